@@ -0,0 +1,101 @@
+#include "FunctionHashTable.h"
+#include <algorithm>
+#include <cstring>
+
+#include "Utils.h"
+
+namespace {
+	uint64_t MixHash( uint64_t hash, uint64_t value ) {
+		hash ^= value + 0x9E3779B97F4A7C15ull + ( hash << 6 ) + ( hash >> 2 );
+		return hash * 0xFF51AFD7ED558CCDull;
+	}
+
+	uint64_t HashBytes( const uint8_t* data, size_t size, uint64_t hash ) {
+		size_t i = 0;
+		for( ; i + sizeof( uint64_t ) <= size; i += sizeof( uint64_t ) ) {
+			uint64_t value;
+			memcpy( &value, data + i, sizeof( value ) );
+			hash = MixHash( hash, value );
+		}
+		uint64_t tail = 0;
+		memcpy( &tail, data + i, size - i );
+		return MixHash( hash, tail );
+	}
+}
+
+void FunctionHashTable::Clear( ) {
+	isBuilt = false;
+	bytes = {};
+	mask = {};
+	functions = {};
+	hashOrder = {};
+}
+
+void FunctionHashTable::BeginBuild( bool wildcard, uint32_t bitmask ) {
+	Clear( );
+	wildcardOperands = wildcard;
+	operandTypeBitmask = bitmask;
+}
+
+void FunctionHashTable::AddFunction( ea_t startEA, const uint8_t* functionBytes, const uint8_t* functionMask, size_t size ) {
+	functions.push_back( { startEA, bytes.size( ), size, 0 } );
+	for( size_t i = 0; i < size; i++ ) {
+		bytes.push_back( functionBytes[i] & functionMask[i] );
+	}
+	mask.insert( mask.end( ), functionMask, functionMask + size );
+}
+
+void FunctionHashTable::FinishBuild( ThreadPool& pool ) {
+	bytes.shrink_to_fit( );
+	mask.shrink_to_fit( );
+	functions.shrink_to_fit( );
+
+	pool.ParallelFor( functions.size( ), [&]( size_t i ) {
+		auto& function = functions[i];
+		const auto hash = HashBytes( bytes.data( ) + function.offset, function.size, function.size );
+		function.hash = HashBytes( mask.data( ) + function.offset, function.size, hash );
+	} );
+
+	hashOrder.resize( functions.size( ) );
+	for( uint32_t i = 0; i < hashOrder.size( ); i++ ) {
+		hashOrder[i] = i;
+	}
+	std::sort( hashOrder.begin( ), hashOrder.end( ), [&]( uint32_t a, uint32_t b ) {
+		return functions[a].hash != functions[b].hash ? functions[a].hash < functions[b].hash : a < b;
+	} );
+	isBuilt = true;
+}
+
+bool FunctionHashTable::IsSameBody( const Function& a, const Function& b ) const {
+	return a.hash == b.hash && a.size == b.size
+		&& memcmp( bytes.data( ) + a.offset, bytes.data( ) + b.offset, a.size ) == 0
+		&& memcmp( mask.data( ) + a.offset, mask.data( ) + b.offset, a.size ) == 0;
+}
+
+std::vector<ea_t> FunctionHashTable::FindIdenticalFunctions( ea_t startEA ) const {
+	std::vector<ea_t> results;
+	if( !isBuilt ) {
+		return results;
+	}
+
+	const auto it = std::lower_bound( functions.begin( ), functions.end( ), startEA, []( const Function& function, ea_t value ) { return function.startEA < value; } );
+	if( it == functions.end( ) || it->startEA != startEA ) {
+		return results;
+	}
+	const auto& function = *it;
+
+	// Equal hashes are adjacent, verify the bytes so a collision never reports a false duplicate
+	const auto first = std::lower_bound( hashOrder.begin( ), hashOrder.end( ), function.hash, [&]( uint32_t index, uint64_t hash ) { return functions[index].hash < hash; } );
+	const auto last = std::upper_bound( first, hashOrder.end( ), function.hash, [&]( uint64_t hash, uint32_t index ) { return hash < functions[index].hash; } );
+	for( auto i = first; i != last; ++i ) {
+		const auto& other = functions[*i];
+		if( other.startEA != startEA && IsSameBody( function, other ) ) {
+			results.push_back( other.startEA );
+		}
+	}
+	return results;
+}
+
+size_t FunctionHashTable::GetMemoryUsage( ) const {
+	return bytes.capacity( ) + mask.capacity( ) + functions.capacity( ) * sizeof( Function ) + hashOrder.capacity( ) * sizeof( uint32_t );
+}
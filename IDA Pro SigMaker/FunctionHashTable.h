@@ -0,0 +1,51 @@
+#pragma once
+#include <vector>
+#include <cstdint>
+
+#include "Plugin.h"
+
+class ThreadPool;
+
+// Hashes of the normalized bodies of all functions, finds functions no signature inside the function can tell apart
+class FunctionHashTable {
+public:
+	void Clear( );
+	bool IsBuilt( ) const {
+		return isBuilt;
+	}
+	bool IsBuiltFor( bool wildcardOperands, uint32_t operandTypeBitmask ) const {
+		return isBuilt && this->wildcardOperands == wildcardOperands && ( !wildcardOperands || this->operandTypeBitmask == operandTypeBitmask );
+	}
+
+	void BeginBuild( bool wildcardOperands, uint32_t operandTypeBitmask );
+	// Body bytes in the order the signature generation reads them, mask is 0 for wildcarded bytes
+	void AddFunction( ea_t startEA, const uint8_t* bytes, const uint8_t* mask, size_t size );
+	// Hashes all functions in parallel on the pool, the bodies were added serially
+	void FinishBuild( ThreadPool& pool );
+
+	// Start addresses of the other functions with the same body, empty if startEA is not in the table
+	std::vector<ea_t> FindIdenticalFunctions( ea_t startEA ) const;
+
+	size_t GetFunctionCount( ) const {
+		return functions.size( );
+	}
+	size_t GetMemoryUsage( ) const;
+
+private:
+	struct Function {
+		ea_t startEA;
+		size_t offset;
+		size_t size;
+		uint64_t hash;
+	};
+
+	bool IsSameBody( const Function& a, const Function& b ) const;
+
+	bool isBuilt = false;
+	bool wildcardOperands = false;
+	uint32_t operandTypeBitmask = 0;
+	std::vector<uint8_t> bytes; // Wildcarded bytes are zero
+	std::vector<uint8_t> mask;
+	std::vector<Function> functions; // Ascending start address
+	std::vector<uint32_t> hashOrder; // Function indices sorted by hash
+};
@@ -0,0 +1,111 @@
+#include "ImageSnapshot.h"
+#include <segment.hpp>
+#include <bytes.hpp>
+#include <algorithm>
+
+bool ImageSnapshot::Create( ) {
+	Invalidate( );
+
+	// Merge adjacent segments into blocks, each block starts at an aligned buffer offset
+	size_t totalSize = 0;
+	for( int i = 0; i < get_segm_qty( ); i++ ) {
+		const auto segment = getnseg( i );
+		if( segment == nullptr || segment->size( ) == 0 ) {
+			continue;
+		}
+
+		if( !blocks.empty( ) && blocks.back( ).endEA == segment->start_ea ) {
+			blocks.back( ).endEA = segment->end_ea;
+			totalSize += segment->size( );
+			continue;
+		}
+
+		totalSize = ( totalSize + Alignment - 1 ) & ~( Alignment - 1 );
+		blocks.push_back( { segment->start_ea, segment->end_ea, totalSize } );
+		totalSize += segment->size( );
+	}
+
+	// Nothing to copy, but still valid so it is not created again for every search. Segment changes invalidate it
+	if( totalSize == 0 ) {
+		blocks.clear( );
+		isValid = true;
+		return true;
+	}
+
+	// Padding at the end so vectorized code can always read a full register
+	size = totalSize;
+	data.reset( new( std::align_val_t{ Alignment } ) uint8_t[totalSize + Alignment]{} );
+	loadedBitmap.assign( ( totalSize + 7 ) / 8 + 1, 0 );
+
+	for( const auto& block : blocks ) {
+		// Read in chunks so we can check for user cancellation, chunk size is a multiple of 8 for the bitmap
+		constexpr size_t chunkSize = 16 * 1024 * 1024;
+		for( auto ea = block.startEA; ea < block.endEA; ea += chunkSize ) {
+			if( user_cancelled( ) ) {
+				Invalidate( );
+				return false;
+			}
+
+			const auto count = static_cast<size_t>( std::min<ea_t>( chunkSize, block.endEA - ea ) );
+			const auto offset = block.offset + static_cast<size_t>( ea - block.startEA );
+
+			// Block offsets are 64-byte aligned, so the bitmap position is always byte aligned
+			get_bytes( data.get( ) + offset, count, ea, GMB_READALL, loadedBitmap.data( ) + offset / 8 );
+		}
+	}
+
+	// Collect runs of loaded bytes
+	for( const auto& block : blocks ) {
+		const auto blockSize = static_cast<size_t>( block.endEA - block.startEA );
+		size_t i = 0;
+		while( i < blockSize ) {
+			while( i < blockSize && !IsLoaded( block.offset + i ) ) {
+				i++;
+			}
+			const auto runStart = i;
+			while( i < blockSize && IsLoaded( block.offset + i ) ) {
+				i++;
+			}
+			if( i > runStart ) {
+				regions.push_back( { block.startEA + runStart, block.offset + runStart, i - runStart } );
+			}
+		}
+	}
+
+	isValid = true;
+	return true;
+}
+
+void ImageSnapshot::Invalidate( ) {
+	isValid = false;
+	data.reset( );
+	size = 0;
+	loadedBitmap.clear( );
+	blocks.clear( );
+	regions.clear( );
+}
+
+const ImageSnapshot::Region* ImageSnapshot::FindRegion( ea_t ea ) const {
+	// Regions are sorted by address
+	auto it = std::upper_bound( regions.begin( ), regions.end( ), ea, []( ea_t value, const Region& region ) { return value < region.startEA; } );
+	if( it == regions.begin( ) ) {
+		return nullptr;
+	}
+	--it;
+	if( ea >= it->startEA + it->size ) {
+		return nullptr;
+	}
+	return &*it;
+}
+
+const uint8_t* ImageSnapshot::GetBytes( ea_t ea, size_t count ) const {
+	const auto region = FindRegion( ea );
+	if( region == nullptr ) {
+		return nullptr;
+	}
+	const auto regionOffset = static_cast<size_t>( ea - region->startEA );
+	if( count > region->size - regionOffset ) {
+		return nullptr;
+	}
+	return data.get( ) + region->offset + regionOffset;
+}
@@ -0,0 +1,68 @@
+#pragma once
+#include <vector>
+#include <memory>
+#include <cstdint>
+
+#include "Plugin.h"
+
+// Flat copy of all segment bytes, so searches run on plain memory instead of IDA's paged byte database
+class ImageSnapshot {
+public:
+	// Run of loaded (initialized) bytes, only these can be matched
+	struct Region {
+		ea_t startEA;
+		size_t offset; // Offset into the snapshot buffer
+		size_t size;
+	};
+
+	// Copy all segments into the snapshot buffer. Returns false if the user cancelled
+	bool Create( );
+	void Invalidate( );
+	bool IsValid( ) const {
+		return isValid;
+	}
+
+	const uint8_t* GetData( ) const {
+		return data.get( );
+	}
+	size_t GetSize( ) const {
+		return size;
+	}
+	const std::vector<Region>& GetRegions( ) const {
+		return regions;
+	}
+
+	// Bitmap lookup, true if the byte at the given buffer offset is initialized
+	bool IsLoaded( size_t offset ) const {
+		return ( loadedBitmap[offset / 8] >> ( offset % 8 ) ) & 1;
+	}
+
+	// Returns a pointer to count loaded bytes at ea, or nullptr if any of them is not loaded
+	const uint8_t* GetBytes( ea_t ea, size_t count ) const;
+
+	// Returns the region containing ea, or nullptr
+	const Region* FindRegion( ea_t ea ) const;
+
+private:
+	// Contiguous segments share one block, so matches can cross segment boundaries like with bin_search3
+	struct Block {
+		ea_t startEA;
+		ea_t endEA;
+		size_t offset;
+	};
+
+	struct AlignedDelete {
+		void operator()( uint8_t* p ) const {
+			::operator delete[]( p, std::align_val_t{ Alignment } );
+		}
+	};
+
+	static constexpr size_t Alignment = 64;
+
+	bool isValid = false;
+	std::unique_ptr<uint8_t[], AlignedDelete> data;
+	size_t size = 0;
+	std::vector<uint8_t> loadedBitmap;
+	std::vector<Block> blocks;
+	std::vector<Region> regions;
+};
@@ -0,0 +1,66 @@
+#include "InstructionCache.h"
+
+#include <algorithm>
+
+void InstructionCache::Clear( ) {
+	pages.clear( );
+	instructionCount = 0;
+}
+
+void InstructionCache::SetOperandTypeBitmask( uint32_t bitmask ) {
+	if( bitmask != operandTypeBitmask ) {
+		Clear( );
+		operandTypeBitmask = bitmask;
+	}
+}
+
+bool InstructionCache::Find( ea_t ea, Instruction& instruction ) const {
+	const auto it = pages.find( ea / PageSize );
+	if( it == pages.end( ) ) {
+		return false;
+	}
+
+	const auto& page = it->second;
+	const auto offset = static_cast<uint16_t>( ea % PageSize );
+	const auto position = std::lower_bound( page.offsets.begin( ), page.offsets.end( ), offset );
+	if( position == page.offsets.end( ) || *position != offset ) {
+		return false;
+	}
+
+	const auto index = position - page.offsets.begin( );
+	instruction.length = page.lengths[index];
+	instruction.operandOffset = page.operandOffsets[index];
+	instruction.operandLength = page.operandLengths[index];
+	return true;
+}
+
+void InstructionCache::Add( ea_t ea, const Instruction& instruction ) {
+	auto& page = pages[ea / PageSize];
+	const auto offset = static_cast<uint16_t>( ea % PageSize );
+
+	// Code is mostly decoded in ascending order, which appends
+	const auto position = std::lower_bound( page.offsets.begin( ), page.offsets.end( ), offset );
+	const auto index = position - page.offsets.begin( );
+	if( position != page.offsets.end( ) && *position == offset ) {
+		page.lengths[index] = instruction.length;
+		page.operandOffsets[index] = instruction.operandOffset;
+		page.operandLengths[index] = instruction.operandLength;
+		return;
+	}
+
+	page.offsets.insert( position, offset );
+	page.lengths.insert( page.lengths.begin( ) + index, instruction.length );
+	page.operandOffsets.insert( page.operandOffsets.begin( ) + index, instruction.operandOffset );
+	page.operandLengths.insert( page.operandLengths.begin( ) + index, instruction.operandLength );
+	instructionCount++;
+}
+
+size_t InstructionCache::GetMemoryUsage( ) const {
+	size_t usage = 0;
+	for( const auto& [pageIndex, page] : pages ) {
+		usage += sizeof( pageIndex ) + sizeof( page );
+		usage += page.offsets.capacity( ) * sizeof( uint16_t );
+		usage += page.lengths.capacity( ) + page.operandOffsets.capacity( ) + page.operandLengths.capacity( );
+	}
+	return usage;
+}
@@ -0,0 +1,44 @@
+#pragma once
+#include <unordered_map>
+#include <vector>
+#include <cstdint>
+
+#include "Plugin.h"
+
+// Decoded instruction lengths and wildcardable operand ranges, stored per page only for the decoded addresses
+// Only used from the UI thread, like decode_insn itself
+class InstructionCache {
+public:
+	struct Instruction {
+		uint8_t length; // 0 if the address could not be decoded
+		uint8_t operandOffset;
+		uint8_t operandLength; // 0 if no operand is wildcardable
+	};
+
+	void Clear( );
+	// The operand ranges depend on the wildcardable operand types, the cache is cleared when they change
+	void SetOperandTypeBitmask( uint32_t operandTypeBitmask );
+
+	bool Find( ea_t ea, Instruction& instruction ) const;
+	void Add( ea_t ea, const Instruction& instruction );
+
+	size_t GetInstructionCount( ) const {
+		return instructionCount;
+	}
+	size_t GetMemoryUsage( ) const;
+
+private:
+	static constexpr size_t PageSize = 0x1000;
+
+	// Sorted offsets of the decoded addresses within the page, with the instructions in parallel arrays
+	struct Page {
+		std::vector<uint16_t> offsets;
+		std::vector<uint8_t> lengths;
+		std::vector<uint8_t> operandOffsets;
+		std::vector<uint8_t> operandLengths;
+	};
+
+	uint32_t operandTypeBitmask = 0;
+	size_t instructionCount = 0;
+	std::unordered_map<ea_t, Page> pages;
+};
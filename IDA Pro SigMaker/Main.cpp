@@ -4,6 +4,59 @@
 #pragma comment(lib,"ida.lib")
 bool IS_ARM = false;
 
+// Copy of the database bytes all searches run on, created on first use and invalidated on changes
+static ImageSnapshot Snapshot;
+
+// Byte frequencies of the snapshot, used to pick search anchors
+static ByteHistogram SnapshotHistogram;
+
+// Optional suffix array over the snapshot regions containing code
+static SuffixIndex CodeIndex;
+static bool UseSearchIndex = false;
+
+// Lighter alternative to the suffix array over the same regions, for images where the suffix array needs too much memory
+static QGramIndex CodeQGrams;
+static bool UseQGramIndex = false;
+
+// Index builds that failed are not retried until the caches are invalidated
+static bool HasSuffixIndexFailed = false;
+static bool HasQGramIndexFailed = false;
+
+// All instructions with their operands zeroed, built together with the search index to speed up wildcarded signatures
+static NormalizedCodeStream CodeStream;
+
+// Normalized function bodies, to detect functions that can not get a unique signature
+static FunctionHashTable FunctionHashes;
+
+// Instruction bounds and wildcarded bytes of the code signatures are generated for, decoded page by page
+static WildcardBitmap WildcardMask;
+
+// Decoded instructions, shared between generation runs
+static InstructionCache DecodedInstructions;
+
+// Worker threads for searches, created on first use
+static std::unique_ptr<ThreadPool> WorkerPool;
+
+static ThreadPool& GetWorkerPool( ) {
+	if( WorkerPool == nullptr ) {
+		WorkerPool = std::make_unique<ThreadPool>( );
+	}
+	return *WorkerPool;
+}
+
+static void InvalidateCaches( ) {
+	WildcardMask.Clear( );
+	DecodedInstructions.Clear( );
+	FunctionHashes.Clear( );
+	CodeStream.Clear( );
+	CodeIndex.Clear( );
+	CodeQGrams.Clear( );
+	HasSuffixIndexFailed = false;
+	HasQGramIndexFailed = false;
+	SetAnchorHistogram( nullptr );
+	Snapshot.Invalidate( );
+}
+
 static bool IsARM( ) {
 	return qstring( "ARM" ) == inf_get_procname() ;
 }
@@ -72,36 +125,795 @@ static bool GetOperand( const insn_t& instruction, uint8_t* operandOffset, uint8
 	return false;
 }
 
+// decode_insn followed by GetOperand. Returns the instruction length, operandLength is 0 if there is no wildcardable operand
+static int DecodeInstructionOperand( ea_t ea, uint32_t operandTypeBitmask, uint8_t* operandOffset, uint8_t* operandLength ) {
+	insn_t instruction;
+	const auto instructionLength = decode_insn( &instruction, ea );
+	if( instructionLength > 0 && !GetOperand( instruction, operandOffset, operandLength, operandTypeBitmask ) ) {
+		*operandOffset = 0;
+		*operandLength = 0;
+	}
+	return instructionLength;
+}
+
+// Same as DecodeInstructionOperand, served from the cache when the address was decoded before
+static int DecodeInstruction( ea_t ea, uint32_t operandTypeBitmask, uint8_t* operandOffset, uint8_t* operandLength ) {
+	DecodedInstructions.SetOperandTypeBitmask( operandTypeBitmask );
+
+	InstructionCache::Instruction cached;
+	if( !DecodedInstructions.Find( ea, cached ) ) {
+		uint8_t decodedOffset = 0, decodedLength = 0;
+		const auto instructionLength = DecodeInstructionOperand( ea, operandTypeBitmask, &decodedOffset, &decodedLength );
+		if( instructionLength > UINT8_MAX ) {
+			// Too long to cache
+			*operandOffset = decodedOffset;
+			*operandLength = decodedLength;
+			return instructionLength;
+		}
+		cached = { static_cast<uint8_t>( std::max( instructionLength, 0 ) ), decodedOffset, decodedLength };
+		DecodedInstructions.Add( ea, cached );
+	}
+
+	*operandOffset = cached.operandOffset;
+	*operandLength = cached.operandLength;
+	return cached.length;
+}
+
+static bool PrepareImageSnapshot( ) {
+	if( Snapshot.IsValid( ) ) {
+		return true;
+	}
+	replace_wait_box( "Creating image snapshot..." );
+	if( !Snapshot.Create( ) ) {
+		return false;
+	}
+	msg( "Image snapshot created (%llu bytes), using %s pattern matcher\n", Snapshot.GetSize( ), GetMatcherLevelName( GetMatcherLevel( ) ) );
+
+	// Count bytes and byte pairs of the loaded regions in chunks, pairs across chunk borders don't matter
+	constexpr size_t chunkSize = 16 * 1024 * 1024;
+	std::vector<std::pair<const uint8_t*, size_t>> chunks;
+	for( const auto& region : Snapshot.GetRegions( ) ) {
+		for( size_t offset = 0; offset < region.size; offset += chunkSize ) {
+			chunks.emplace_back( Snapshot.GetData( ) + region.offset + offset, std::min( chunkSize, region.size - offset ) );
+		}
+	}
+	std::vector<ByteHistogram> chunkHistograms( chunks.size( ) );
+	GetWorkerPool( ).ParallelFor( chunks.size( ), [&]( size_t i ) {
+		AddToByteHistogram( chunkHistograms[i], chunks[i].first, chunks[i].second );
+	} );
+
+	SnapshotHistogram = {};
+	for( const auto& chunkHistogram : chunkHistograms ) {
+		MergeByteHistogram( SnapshotHistogram, chunkHistogram );
+	}
+	SetAnchorHistogram( &SnapshotHistogram );
+	return true;
+}
+
+static bool IsCodeSegment( const segment_t* segment ) {
+	return segment->type == SEG_CODE || ( segment->perm & SEGPERM_EXEC ) != 0;
+}
+
+static bool IsSearchIndexBuilt( ) {
+	return CodeIndex.IsBuilt( ) || CodeQGrams.IsBuilt( );
+}
+
+// Whether ea lies in a region the search index covers
+static bool IsIndexedAddress( ea_t ea ) {
+	return CodeIndex.Contains( ea ) || CodeQGrams.Contains( ea );
+}
+
+// Returns false if the pattern can not be answered by the index that is built
+static bool FindInSearchIndex( const CompiledPattern& pattern, std::vector<ea_t>& results, size_t maxResults ) {
+	if( CodeIndex.IsBuilt( ) ) {
+		return CodeIndex.Find( pattern, results, maxResults );
+	}
+	return CodeQGrams.Find( pattern, results, maxResults );
+}
+
+static bool PrepareSearchIndex( ) {
+	if( IsSearchIndexBuilt( ) ) {
+		return true;
+	}
+	if( UseQGramIndex && HasQGramIndexFailed ) {
+		UseSearchIndex = false;
+		return false;
+	}
+
+	// Index whole regions that contain code, so every match lies either completely inside or outside of the index
+	std::vector<SuffixIndex::TextRun> runs;
+	for( const auto& region : Snapshot.GetRegions( ) ) {
+		const auto regionEnd = region.startEA + region.size;
+		for( auto ea = region.startEA; ea < regionEnd; ) {
+			const auto segment = getseg( ea );
+			if( segment == nullptr ) {
+				break;
+			}
+			if( IsCodeSegment( segment ) ) {
+				runs.push_back( { region.startEA, Snapshot.GetData( ) + region.offset, region.size } );
+				break;
+			}
+			ea = segment->end_ea;
+		}
+	}
+
+	replace_wait_box( "Building search index..." );
+	const auto startTime = std::chrono::steady_clock::now( );
+	if( !UseQGramIndex && !CodeIndex.Build( runs ) ) {
+		// The q-gram index has no limit on the total size
+		msg( "Failed to build suffix array, falling back to q-gram index\n" );
+		HasSuffixIndexFailed = true;
+		UseQGramIndex = true;
+	}
+	if( UseQGramIndex ) {
+		std::vector<QGramIndex::TextRun> qgramRuns;
+		for( const auto& run : runs ) {
+			qgramRuns.push_back( { run.startEA, run.data, run.size } );
+		}
+		if( !CodeQGrams.Build( qgramRuns ) ) {
+			// Don't retry for every search
+			msg( "Failed to build search index, falling back to linear search\n" );
+			HasQGramIndexFailed = true;
+			UseSearchIndex = false;
+			return false;
+		}
+	}
+	const auto buildTime = std::chrono::duration_cast<std::chrono::milliseconds>( std::chrono::steady_clock::now( ) - startTime );
+	if( UseQGramIndex ) {
+		msg( "Q-gram index built over %llu bytes of code in %lld ms, using %llu MB\n", CodeQGrams.GetTextSize( ), buildTime.count( ), CodeQGrams.GetMemoryUsage( ) / ( 1024 * 1024 ) );
+	}
+	else {
+		msg( "Search index built over %llu bytes of code in %lld ms, using %llu MB\n", CodeIndex.GetTextSize( ), buildTime.count( ), CodeIndex.GetMemoryUsage( ) / ( 1024 * 1024 ) );
+	}
+	return true;
+}
+
+// Convert IDA's parsed pattern for the search kernels
+static CompiledPattern CompileBinaryPattern( const compiled_binpat_t& binaryPattern ) {
+	CompiledPattern pattern;
+	for( size_t i = 0; i < binaryPattern.bytes.size( ); i++ ) {
+		AppendPatternByte( pattern, binaryPattern.bytes[i], binaryPattern.all_bytes_defined( ) ? 0xFF : binaryPattern.mask[i] );
+	}
+	SelectPatternAnchors( pattern );
+	return pattern;
+}
+
+// Search engine chosen in the settings, Automatic lets the planner pick one per pattern
+static SearchEngine PreferredSearchEngine = SearchEngine::Automatic;
+
+// Plans and timings of all searches since the last action
+static SearchPlanAudit SearchAudit;
+
+static SearchPlan PlanSearch( const CompiledPattern& pattern ) {
+	const auto histogram = Snapshot.IsValid( ) ? &SnapshotHistogram : nullptr;
+	auto plan = PlanPatternSearch( pattern, histogram, UseSearchIndex );
+	if( PreferredSearchEngine != SearchEngine::Automatic && CanUseSearchEngine( PreferredSearchEngine, pattern ) ) {
+		plan.engine = PreferredSearchEngine;
+		plan.estimatedCost = EstimateSearchCost( plan.engine, pattern, histogram );
+	}
+	return plan;
+}
+
+// Part of a snapshot region, searched by one worker
+struct SearchChunk {
+	ea_t startEA;
+	const uint8_t* data;
+	size_t size;
+};
+
+// Split the loaded regions into chunks that overlap by the pattern length - 1, so no match is lost at chunk borders
+static std::vector<SearchChunk> SplitSnapshotRegions( size_t patternSize, bool skipIndexedRegions ) {
+	constexpr size_t chunkPositions = 4 * 1024 * 1024;
+
+	std::vector<SearchChunk> chunks;
+	for( const auto& region : Snapshot.GetRegions( ) ) {
+		if( ( skipIndexedRegions && IsIndexedAddress( region.startEA ) ) || region.size < patternSize ) {
+			continue;
+		}
+
+		const auto positionCount = region.size - patternSize + 1;
+		for( size_t position = 0; position < positionCount; position += chunkPositions ) {
+			const auto chunkSize = std::min( chunkPositions, positionCount - position ) + patternSize - 1;
+			chunks.push_back( { region.startEA + position, Snapshot.GetData( ) + region.offset + position, chunkSize } );
+		}
+	}
+	return chunks;
+}
+
+// Scan the loaded regions of the snapshot with the given engine, optionally leaving out the indexed ones. Returns the number of bytes searched
+static size_t ScanSnapshotRegions( const CompiledPattern& pattern, SearchEngine engine, bool skipIndexedRegions, std::vector<ea_t>& results, size_t maxResults ) {
+	const auto chunks = SplitSnapshotRegions( pattern.size( ), skipIndexedRegions );
+
+	// Each chunk has its own result list, merged in address order afterwards
+	std::vector<std::vector<size_t>> chunkResults( chunks.size( ) );
+	std::atomic<size_t> foundCount = results.size( );
+	std::atomic<size_t> scannedBytes = 0;
+	GetWorkerPool( ).ParallelFor( chunks.size( ), [&]( size_t i ) {
+		// Someone else already found enough, e.g. two matches when only checking uniqueness
+		if( foundCount >= maxResults ) {
+			return;
+		}
+		FindPatternWithEngine( engine, pattern, chunks[i].data, chunks[i].size, chunkResults[i], maxResults );
+		foundCount += chunkResults[i].size( );
+		scannedBytes += chunks[i].size;
+	} );
+
+	for( size_t i = 0; i < chunks.size( ) && results.size( ) < maxResults; i++ ) {
+		for( const auto offset : chunkResults[i] ) {
+			if( results.size( ) >= maxResults ) {
+				break;
+			}
+			results.push_back( chunks[i].startEA + offset );
+		}
+	}
+	return scannedBytes.load( );
+}
+
+// Search all loaded regions of the snapshot for the pattern as planned, every search goes through here
+// Only uses the search index if it is already built, so this can run on worker threads
+static void FindPatternInSnapshot( const CompiledPattern& pattern, std::vector<ea_t>& results, size_t maxResults ) {
+	auto plan = PlanSearch( pattern );
+	const auto startTime = std::chrono::steady_clock::now( );
+	const auto previousCount = results.size( );
+
+	// Indexed regions are answered by the suffix array, everything else is scanned
+	plan.useIndex = plan.useIndex && IsSearchIndexBuilt( ) && FindInSearchIndex( pattern, results, maxResults );
+	size_t scannedBytes = 0;
+	if( results.size( ) < maxResults ) {
+		scannedBytes = ScanSnapshotRegions( pattern, plan.engine, plan.useIndex, results, maxResults );
+	}
+
+	const auto searchTime = std::chrono::duration<double, std::milli>( std::chrono::steady_clock::now( ) - startTime );
+	SearchAudit.Record( plan, scannedBytes, results.size( ) - previousCount, searchTime.count( ) );
+}
+
+// Print which engines the planner picked and how they performed against their estimates
+static void PrintSearchAudit( ) {
+	for( const auto engine : { SearchEngine::Anchor, SearchEngine::Horspool, SearchEngine::ShiftOr } ) {
+		const auto statistics = SearchAudit.GetStatistics( engine );
+		if( statistics.searchCount == 0 ) {
+			continue;
+		}
+		const auto averageCost = statistics.estimatedCost / statistics.searchCount;
+		const auto nanosecondsPerByte = statistics.scannedBytes != 0 ? statistics.milliseconds * 1e6 / statistics.scannedBytes : 0.0;
+		msg( "%-12s %llu searches (%llu with index), %llu MB scanned, %llu matches, %.2f ms, estimated %.3f cycles/byte, measured %.3f ns/byte\n",
+			GetSearchEngineName( engine ), statistics.searchCount, statistics.indexedCount, statistics.scannedBytes / ( 1024 * 1024 ), statistics.resultCount,
+			statistics.milliseconds, averageCost, nanosecondsPerByte );
+	}
+}
+
+// Same as FindSignatureOccurences without preparing anything, safe to run on worker threads. Finds nothing without a snapshot
+static std::vector<ea_t> LookupSignatureOccurences( std::span<const CompiledPattern> patterns, bool skipMoreThanOne = false ) {
+	std::vector<ea_t> results;
+	if( !Snapshot.IsValid( ) ) {
+		return results;
+	}
+
+	//  In case we only care about uniqueness, stop after more than one result
+	const auto maxResults = skipMoreThanOne ? 2 : SIZE_MAX;
+
+	// Search for occurences
+	for( const auto& pattern : patterns ) {
+		FindPatternInSnapshot( pattern, results, maxResults );
+	}
+
+	// Index lookups and multiple patterns can produce unordered or overlapping results
+	std::ranges::sort( results );
+	const auto [first, last] = std::ranges::unique( results );
+	results.erase( first, last );
+	return results;
+}
+
+static std::vector<ea_t> FindSignatureOccurences( std::span<const CompiledPattern> patterns, bool skipMoreThanOne = false ) {
+	if( !PrepareImageSnapshot( ) ) {
+		return {};
+	}
+	if( UseSearchIndex ) {
+		PrepareSearchIndex( );
+	}
+	return LookupSignatureOccurences( patterns, skipMoreThanOne );
+}
+
+static std::vector<ea_t> FindSignatureOccurences( const CompiledPattern& pattern, bool skipMoreThanOne = false ) {
+	return FindSignatureOccurences( std::span( &pattern, 1 ), skipMoreThanOne );
+}
+
 static std::vector<ea_t> FindSignatureOccurences( std::string_view idaSignature, bool skipMoreThanOne = false ) {
 	// Convert signature string to searchable struct
 	compiled_binpat_vec_t binaryPattern;
 	parse_binpat_str( &binaryPattern, inf_get_min_ea(), idaSignature.data( ), 16 );
 
-	// Search for occurences
-	std::vector<ea_t> results;
-	auto ea = inf_get_min_ea();
-	while( true ) {
-		auto occurence = bin_search3( ea, inf_get_max_ea(), binaryPattern, BIN_SEARCH_NOCASE | BIN_SEARCH_FORWARD);
+	std::vector<CompiledPattern> patterns;
+	for( const auto& pattern : binaryPattern ) {
+		patterns.push_back( CompileBinaryPattern( pattern ) );
+	}
+	return FindSignatureOccurences( patterns, skipMoreThanOne );
+}
 
-		// Signature not found anymore
-		if( occurence == BADADDR ) {
+// Location matching a signature except for some bytes
+struct ApproximateOccurence {
+	ea_t ea;
+	size_t mismatches;
+};
+
+// Find all locations matching the signature with at most maxMismatches differing bytes, fewest mismatches first
+static std::vector<ApproximateOccurence> FindApproximateSignatureOccurences( std::string_view idaSignature, size_t maxMismatches ) {
+	std::vector<ApproximateOccurence> occurences;
+	if( !PrepareImageSnapshot( ) ) {
+		return occurences;
+	}
+	if( UseSearchIndex ) {
+		PrepareSearchIndex( );
+	}
+
+	compiled_binpat_vec_t binaryPattern;
+	parse_binpat_str( &binaryPattern, inf_get_min_ea(), idaSignature.data( ), 16 );
+
+	for( const auto& binaryPatternPart : binaryPattern ) {
+		const auto pattern = CompileBinaryPattern( binaryPatternPart );
+
+		// Every location with at most maxMismatches differing bytes matches one of the pieces exactly
+		std::vector<ea_t> candidates;
+		for( const auto& piece : SplitPattern( pattern, maxMismatches + 1 ) ) {
+			std::vector<ea_t> pieceMatches;
+			FindPatternInSnapshot( piece.pattern, pieceMatches, SIZE_MAX );
+			for( const auto ea : pieceMatches ) {
+				if( ea >= piece.offset ) {
+					candidates.push_back( ea - piece.offset );
+				}
+			}
+		}
+		std::ranges::sort( candidates );
+		const auto [first, last] = std::ranges::unique( candidates );
+		candidates.erase( first, last );
+
+		// Count the differing bytes of the candidates in blocks on the worker pool
+		constexpr size_t blockSize = 4096;
+		const auto blockCount = ( candidates.size( ) + blockSize - 1 ) / blockSize;
+		std::vector<std::vector<ApproximateOccurence>> blockResults( blockCount );
+		GetWorkerPool( ).ParallelFor( blockCount, [&]( size_t block ) {
+			const auto end = std::min( candidates.size( ), ( block + 1 ) * blockSize );
+			for( auto i = block * blockSize; i < end; i++ ) {
+				const auto bytes = Snapshot.GetBytes( candidates[i], pattern.size( ) );
+				if( bytes == nullptr ) {
+					continue;
+				}
+				const auto mismatches = CountPatternMismatches( pattern, bytes, maxMismatches );
+				if( mismatches <= maxMismatches ) {
+					blockResults[block].push_back( { candidates[i], mismatches } );
+				}
+			}
+		} );
+		for( const auto& block : blockResults ) {
+			occurences.insert( occurences.end( ), block.begin( ), block.end( ) );
+		}
+	}
+
+	// Keep the best match per address, then rank by mismatch count
+	std::ranges::sort( occurences, []( const ApproximateOccurence& a, const ApproximateOccurence& b ) {
+		return a.ea != b.ea ? a.ea < b.ea : a.mismatches < b.mismatches;
+	} );
+	const auto [first, last] = std::ranges::unique( occurences, {}, &ApproximateOccurence::ea );
+	occurences.erase( first, last );
+	std::ranges::stable_sort( occurences, {}, &ApproximateOccurence::mismatches );
+	return occurences;
+}
+
+// Append the instruction bytes with one read, from the snapshot if possible. An operandLength of 0 means no wildcards
+static void AddInstructionToSignature( Signature& signature, ea_t address, size_t instructionLength, size_t operandOffset, size_t operandLength ) {
+	std::vector<uint8_t> buffer;
+	auto bytes = Snapshot.IsValid( ) ? Snapshot.GetBytes( address, instructionLength ) : nullptr;
+	if( bytes == nullptr ) {
+		buffer.resize( instructionLength );
+		get_bytes( buffer.data( ), instructionLength, address, GMB_READALL );
+		bytes = buffer.data( );
+	}
+
+	// Never wildcard past the end of the instruction
+	operandOffset = std::min( operandOffset, instructionLength );
+	operandLength = std::min( operandLength, instructionLength - operandOffset );
+	if( operandLength == 0 ) {
+		AddBytesToSignature( signature, bytes, instructionLength, false );
+		return;
+	}
+
+	// Add opcodes
+	AddBytesToSignature( signature, bytes, operandOffset, false );
+	// Wildcards for operands
+	AddBytesToSignature( signature, bytes + operandOffset, operandLength, true );
+	// If the operand is on the "left side", add the operator from the "right side"
+	if( operandOffset == 0 ) {
+		AddBytesToSignature( signature, bytes + operandLength, instructionLength - operandLength, false );
+	}
+}
+
+// Append an instruction the wildcard bitmap knows, as a slice of its bytes and mask bits
+static void AddInstructionSliceToSignature( Signature& signature, ea_t address, size_t instructionLength ) {
+	std::vector<uint8_t> buffer;
+	auto bytes = Snapshot.IsValid( ) ? Snapshot.GetBytes( address, instructionLength ) : nullptr;
+	if( bytes == nullptr ) {
+		buffer.resize( instructionLength );
+		get_bytes( buffer.data( ), instructionLength, address, GMB_READALL );
+		bytes = buffer.data( );
+	}
+
+	const auto previousSize = signature.size( );
+	signature.Append( bytes, instructionLength, false );
+	for( size_t i = 0; i < instructionLength; i++ ) {
+		if( WildcardMask.IsWildcard( address + i ) ) {
+			signature.Set( previousSize + i, bytes[i], true );
+		}
+	}
+}
+
+// Check if the signature matches at the given address, only comparing bytes from startOffset on
+static bool DoesSignatureMatchAt( const Signature& signature, ea_t ea, size_t startOffset = 0 ) {
+	if( startOffset >= signature.size( ) ) {
+		return true;
+	}
+
+	// Uninitialized bytes never match, same as bin_search3
+	const auto bytes = Snapshot.GetBytes( ea + startOffset, signature.size( ) - startOffset );
+	if( bytes == nullptr ) {
+		return false;
+	}
+
+	return signature.Matches( bytes, startOffset );
+}
+
+// Remove all candidates that do not match the bytes appended to the signature since the last call
+static void NarrowSignatureCandidates( const Signature& signature, std::vector<ea_t>& candidates, size_t previousSignatureSize ) {
+	std::erase_if( candidates, [&]( ea_t candidate ) { return !DoesSignatureMatchAt( signature, candidate, previousSignatureSize ); } );
+}
+
+static bool PrepareCodeStream( uint32_t operandTypeBitmask ) {
+	if( CodeStream.IsBuilt( ) && CodeStream.GetOperandTypeBitmask( ) == operandTypeBitmask ) {
+		return true;
+	}
+	if( !PrepareImageSnapshot( ) ) {
+		return false;
+	}
+
+	replace_wait_box( "Building normalized code stream..." );
+	const auto startTime = std::chrono::steady_clock::now( );
+
+	// Decode every instruction once and zero the same operand bytes the signature generation would wildcard
+	CodeStream.BeginBuild( operandTypeBitmask );
+	size_t instructionCount = 0;
+	for( int i = 0; i < get_segm_qty( ); i++ ) {
+		const auto segment = getnseg( i );
+		if( segment == nullptr || !IsCodeSegment( segment ) ) {
+			continue;
+		}
+
+		for( auto ea = segment->start_ea; ea < segment->end_ea; ea = next_head( ea, segment->end_ea ) ) {
+			if( ( ++instructionCount % 0x10000 ) == 0 && user_cancelled( ) ) {
+				CodeStream.Clear( );
+				return false;
+			}
+
+			if( !is_code( get_flags( ea ) ) ) {
+				continue;
+			}
+
+			uint8_t operandOffset = 0, operandLength = 0;
+			const auto instructionLength = DecodeInstruction( ea, operandTypeBitmask, &operandOffset, &operandLength );
+			if( instructionLength <= 0 ) {
+				continue;
+			}
+
+			const auto bytes = Snapshot.GetBytes( ea, instructionLength );
+			if( bytes == nullptr ) {
+				continue;
+			}
+			CodeStream.AddInstruction( ea, bytes, instructionLength, operandOffset, operandLength );
+		}
+	}
+	CodeStream.FinishBuild( true, UseQGramIndex );
+
+	const auto buildTime = std::chrono::duration_cast<std::chrono::milliseconds>( std::chrono::steady_clock::now( ) - startTime );
+	msg( "Normalized code stream built over %llu bytes in %lld ms, using %llu MB\n", CodeStream.GetSize( ), buildTime.count( ), CodeStream.GetMemoryUsage( ) / ( 1024 * 1024 ) );
+	msg( "Instruction cache holds %llu instructions, using %llu MB\n", DecodedInstructions.GetInstructionCount( ), DecodedInstructions.GetMemoryUsage( ) / ( 1024 * 1024 ) );
+	return true;
+}
+
+// Decode the code heads of the page containing ea into the wildcard bitmap, once per page
+static void PrepareWildcardPage( ea_t ea, uint32_t operandTypeBitmask ) {
+	WildcardMask.SetOperandTypeBitmask( operandTypeBitmask );
+	if( WildcardMask.IsPageDecoded( ea ) ) {
+		return;
+	}
+
+	const auto pageStart = ea - ea % WildcardBitmap::PageSize;
+	const auto pageEnd = pageStart + WildcardBitmap::PageSize;
+	auto head = is_head( get_flags( pageStart ) ) ? pageStart : next_head( pageStart, pageEnd );
+	for( ; head != BADADDR && head < pageEnd; head = next_head( head, pageEnd ) ) {
+		if( !is_code( get_flags( head ) ) ) {
+			continue;
+		}
+
+		// Straight to the decoder, the bitmap replaces the instruction cache for these addresses
+		uint8_t operandOffset = 0, operandLength = 0;
+		const auto instructionLength = DecodeInstructionOperand( head, operandTypeBitmask, &operandOffset, &operandLength );
+		if( instructionLength <= 0 || Snapshot.GetBytes( head, instructionLength ) == nullptr ) {
+			continue;
+		}
+		WildcardMask.AddInstruction( head, instructionLength, operandOffset, operandLength );
+	}
+	WildcardMask.SetPageDecoded( ea );
+}
+
+// Length of the code head at ea from the wildcard bitmap, its page is decoded on first use
+// Returns 0 if no known instruction starts there, e.g. when the linear decode left the IDA heads
+static size_t GetBitmapInstructionLength( ea_t ea, uint32_t operandTypeBitmask ) {
+	if( !PrepareImageSnapshot( ) ) {
+		return 0;
+	}
+	PrepareWildcardPage( ea, operandTypeBitmask );
+	return WildcardMask.GetInstructionLength( ea );
+}
+
+static bool PrepareFunctionHashes( bool wildcardOperands, uint32_t operandTypeBitmask ) {
+	if( FunctionHashes.IsBuiltFor( wildcardOperands, operandTypeBitmask ) ) {
+		return true;
+	}
+	if( !PrepareImageSnapshot( ) ) {
+		return false;
+	}
+
+	replace_wait_box( "Hashing function bodies..." );
+	const auto startTime = std::chrono::steady_clock::now( );
+
+	// Decode like the signature generation does from the function start, until it leaves the function.
+	// Functions with tail chunks are left out, their bodies are not contiguous
+	FunctionHashes.BeginBuild( wildcardOperands, operandTypeBitmask );
+	Signature body;
+	std::vector<uint8_t> bytes, mask;
+	for( size_t i = 0; i < get_func_qty( ); i++ ) {
+		if( ( i % 256 ) == 0 && user_cancelled( ) ) {
+			FunctionHashes.Clear( );
+			return false;
+		}
+
+		const auto function = getn_func( i );
+		if( function == nullptr || function->tailqty > 0 ) {
+			continue;
+		}
+
+		body.clear( );
+		bool isLoaded = true;
+		for( auto ea = function->start_ea; ea < function->end_ea; ) {
+			uint8_t operandOffset = 0, operandLength = 0;
+			const auto instructionLength = DecodeInstruction( ea, operandTypeBitmask, &operandOffset, &operandLength );
+			if( instructionLength <= 0 ) {
+				break;
+			}
+			if( Snapshot.GetBytes( ea, instructionLength ) == nullptr ) {
+				isLoaded = false;
+				break;
+			}
+
+			if( !wildcardOperands ) {
+				operandLength = 0;
+			}
+			AddInstructionToSignature( body, ea, instructionLength, operandOffset, operandLength );
+			ea += instructionLength;
+		}
+		if( !isLoaded || body.empty( ) ) {
+			continue;
+		}
+
+		bytes.resize( body.size( ) );
+		mask.resize( body.size( ) );
+		for( size_t j = 0; j < body.size( ); j++ ) {
+			bytes[j] = body.GetByte( j );
+			mask[j] = body.IsWildcard( j ) ? 0x00 : 0xFF;
+		}
+		FunctionHashes.AddFunction( function->start_ea, bytes.data( ), mask.data( ), body.size( ) );
+	}
+	FunctionHashes.FinishBuild( GetWorkerPool( ) );
+
+	const auto buildTime = std::chrono::duration_cast<std::chrono::milliseconds>( std::chrono::steady_clock::now( ) - startTime );
+	msg( "Hashed %llu function bodies in %lld ms, using %llu MB\n", FunctionHashes.GetFunctionCount( ), buildTime.count( ), FunctionHashes.GetMemoryUsage( ) / ( 1024 * 1024 ) );
+	msg( "Instruction cache holds %llu instructions, using %llu MB\n", DecodedInstructions.GetInstructionCount( ), DecodedInstructions.GetMemoryUsage( ) / ( 1024 * 1024 ) );
+	return true;
+}
+
+// Other functions with the same body as the function containing ea. Every signature that starts anywhere in it
+// and stays inside the function also matches them at the same offset
+static std::vector<ea_t> FindIdenticalFunctions( ea_t ea, bool wildcardOperands, bool continueOutsideOfFunction, uint32_t operandTypeBitmask ) {
+	if( continueOutsideOfFunction || !FunctionHashes.IsBuiltFor( wildcardOperands, operandTypeBitmask ) ) {
+		return {};
+	}
+	const auto function = get_func( ea );
+	if( function == nullptr ) {
+		return {};
+	}
+	return FunctionHashes.FindIdenticalFunctions( function->start_ea );
+}
+
+// First few addresses for messages
+static std::string FormatAddressList( const std::vector<ea_t>& addresses ) {
+	std::string result;
+	for( size_t i = 0; i < addresses.size( ) && i < 5; i++ ) {
+		result += std::format( "{}{:X}", i > 0 ? ", " : "", addresses[i] );
+	}
+	if( addresses.size( ) > 5 ) {
+		result += std::format( " and {} more", addresses.size( ) - 5 );
+	}
+	return result;
+}
+
+static std::string FormatIdenticalFunctions( const std::vector<ea_t>& identicalFunctions ) {
+	return std::format( "Function is identical to {} other functions ({})", identicalFunctions.size( ), FormatAddressList( identicalFunctions ) );
+}
+
+// Exact lookup of the wildcarded signature in the normalized code stream. This only finds instruction aligned matches,
+// so it can prove that a signature is not unique yet, but not that it is unique. Never builds the stream, without it nothing is proven
+static bool HasMultipleNormalizedMatches( const Signature& signature, uint32_t operandTypeBitmask ) {
+	if( !CodeStream.IsBuilt( ) || CodeStream.GetOperandTypeBitmask( ) != operandTypeBitmask ) {
+		return false;
+	}
+
+	std::vector<uint8_t> normalizedBytes( signature.size( ) );
+	for( size_t i = 0; i < signature.size( ); i++ ) {
+		normalizedBytes[i] = signature.IsWildcard( i ) ? 0 : signature.GetByte( i );
+	}
+
+	std::vector<ea_t> matches;
+	CodeStream.Find( normalizedBytes.data( ), normalizedBytes.size( ), matches, 64 );
+
+	// Zeroed operand bytes in the stream can hide differences, so check the real bytes
+	size_t verifiedMatches = 0;
+	for( const auto match : matches ) {
+		if( DoesSignatureMatchAt( signature, match ) && ++verifiedMatches > 1 ) {
+			return true;
+		}
+	}
+	return false;
+}
+
+// Addresses matching a growing signature. The database is only scanned once,
+// every following instruction just narrows down this set
+struct SignatureCandidates {
+	std::vector<ea_t> addresses;
+	bool isInitialized = false;
+
+	// Search pattern of the signature, grows together with it
+	CompiledPattern pattern;
+};
+
+// Update the candidates after bytes were appended to the signature, returns true once the signature is unique
+// Only looks up caches and never builds them, so it can run on worker threads. Prepare them with PrepareSearchCaches first
+static bool UpdateSignatureCandidates( SignatureCandidates& candidates, const Signature& signature, size_t previousSignatureSize, bool wildcardOperands, uint32_t operandTypeBitmask ) {
+	AppendSignatureToPattern( candidates.pattern, signature, previousSignatureSize );
+
+	if( candidates.isInitialized ) {
+		// Only check the new bytes of the remaining candidates
+		NarrowSignatureCandidates( signature, candidates.addresses, previousSignatureSize );
+	}
+	// With the search index enabled, short wildcarded prefixes are usually rejected by an index lookup
+	// That way the full scan happens later, when there are less candidates to track
+	else if( !( wildcardOperands && UseSearchIndex && HasMultipleNormalizedMatches( signature, operandTypeBitmask ) ) ) {
+		// Full database scan, only done once
+		SelectPatternAnchors( candidates.pattern );
+		candidates.addresses = LookupSignatureOccurences( std::span( &candidates.pattern, 1 ) );
+		candidates.isInitialized = true;
+	}
+
+	return candidates.isInitialized && candidates.addresses.size( ) == 1;
+}
+
+// Everything worker threads search on has to exist before they start
+static bool PrepareSearchCaches( bool wildcardOperands, uint32_t operandTypeBitmask ) {
+	if( !PrepareImageSnapshot( ) ) {
+		return false;
+	}
+	// A failed index build already fell back to linear search, the code stream is only used together with the index
+	if( UseSearchIndex && PrepareSearchIndex( ) && wildcardOperands && !PrepareCodeStream( operandTypeBitmask ) ) {
+		return false;
+	}
+	return true;
+}
+
+// Why decoding a signature target stopped
+enum class TargetStop {
+	MaximumLength,
+	CodeEnded,
+	LeftFunction
+};
+
+// Reported if no prefix of the target is unique
+static const char* GetTargetStopReason( TargetStop stop ) {
+	switch( stop ) {
+	case TargetStop::MaximumLength:
+		return "Signature exceeded maximum length";
+	case TargetStop::LeftFunction:
+		return "Signature left function scope";
+	default:
+		return "Signature not unique";
+	}
+}
+
+// Bytes of a signature target decoded up to the maximum length on the UI thread,
+// the shortest unique prefix is then searched without calling into IDA
+struct SignatureTarget {
+	ea_t ea = BADADDR;
+	Signature signature;
+	std::vector<size_t> instructionEnds; // Signature size after each instruction
+	TargetStop stop = TargetStop::CodeEnded;
+};
+
+static std::expected<SignatureTarget, std::string> DecodeSignatureTarget( ea_t ea, bool wildcardOperands, bool continueOutsideOfFunction, uint32_t operandTypeBitmask, size_t maxSignatureLength ) {
+	if( ea == BADADDR ) {
+		return std::unexpected( "Invalid address" );
+	}
+
+	if( !is_code( get_flags( ea ) ) ) {
+		return std::unexpected( "Can not create code signature for data" );
+	}
+
+	SignatureTarget target;
+	target.ea = ea;
+
+	const auto currentFunction = get_func( ea );
+	auto currentAddress = ea;
+	while( true ) {
+		if( target.signature.size( ) > maxSignatureLength ) {
+			target.stop = TargetStop::MaximumLength;
 			break;
 		}
 
-		//  In case we only care about uniqueness, return after more than one result
-		if( skipMoreThanOne && results.size( ) > 1 ) {
+		// Instructions the wildcard bitmap knows are added without decoding them
+		uint8_t operandOffset = 0, operandLength = 0;
+		const auto bitmapInstructionLength = wildcardOperands ? GetBitmapInstructionLength( currentAddress, operandTypeBitmask ) : 0;
+		const auto currentInstructionLength = bitmapInstructionLength > 0 ? static_cast<int>( bitmapInstructionLength ) : DecodeInstruction( currentAddress, operandTypeBitmask, &operandOffset, &operandLength );
+		if( currentInstructionLength <= 0 ) {
+			if( target.signature.empty( ) ) {
+				return std::unexpected( "Failed to decode first instruction" );
+			}
+			target.stop = TargetStop::CodeEnded;
 			break;
 		}
 
-		results.push_back( occurence );
+		if( bitmapInstructionLength > 0 ) {
+			AddInstructionSliceToSignature( target.signature, currentAddress, bitmapInstructionLength );
+		}
+		else {
+			if( !wildcardOperands ) {
+				operandLength = 0;
+			}
+			AddInstructionToSignature( target.signature, currentAddress, currentInstructionLength, operandOffset, operandLength );
+		}
+		target.instructionEnds.push_back( target.signature.size( ) );
 
-		ea = occurence + 1;
+		currentAddress += currentInstructionLength;
+
+		if( !continueOutsideOfFunction && currentFunction && get_func( currentAddress ) != currentFunction ) {
+			target.stop = TargetStop::LeftFunction;
+			break;
+		}
 	}
-	return results;
+	return target;
+}
+
+// Other candidates that match the whole decoded window of the target. No signature taken from the window can ever exclude them
+static std::vector<ea_t> FindIndistinguishableCandidates( const SignatureTarget& target, const std::vector<ea_t>& candidates ) {
+	std::vector<ea_t> result;
+	for( const auto candidate : candidates ) {
+		if( candidate != target.ea && DoesSignatureMatchAt( target.signature, candidate ) ) {
+			result.push_back( candidate );
+		}
+	}
+	return result;
 }
 
-static bool IsSignatureUnique( std::string_view idaSignature ) {
-	return FindSignatureOccurences( idaSignature, true ).size( ) == 1;
+static std::string FormatIndistinguishableCandidates( const SignatureTarget& target, const std::vector<ea_t>& candidates ) {
+	// Only windows decoded up to a limited length stop here, which are the targets of FindUniqueSignaturePrefix
+	if( target.stop == TargetStop::MaximumLength ) {
+		return std::format( "Signature exceeded maximum length, {} match the first {} bytes", FormatAddressList( candidates ), target.signature.size( ) );
+	}
+	return std::format( "Signature not unique, {} match the target until it leaves the function or code ends", FormatAddressList( candidates ) );
 }
 
 static std::expected<Signature, std::string> GenerateUniqueSignatureForEA( ea_t ea, bool wildcardOperands, bool continueOutsideOfFunction, uint32_t operandTypeBitmask, size_t maxSignatureLength = 1000, bool askLongerSignature = true ) {
@@ -113,9 +925,19 @@ static std::expected<Signature, std::string> GenerateUniqueSignatureForEA( ea_t
 		return std::unexpected( "Can not create code signature for data" );
 	}
 
+	if( const auto identicalFunctions = FindIdenticalFunctions( ea, wildcardOperands, continueOutsideOfFunction, operandTypeBitmask ); !identicalFunctions.empty( ) ) {
+		return std::unexpected( FormatIdenticalFunctions( identicalFunctions ) );
+	}
+
+	if( !PrepareSearchCaches( wildcardOperands, operandTypeBitmask ) ) {
+		return std::unexpected( "Aborted" );
+	}
+
 	Signature signature;
 	size_t sigPartLength = 0;
 
+	SignatureCandidates candidates;
+
 	auto currentFunction = get_func( ea );
 
 	auto currentAddress = ea;
@@ -125,8 +947,10 @@ static std::expected<Signature, std::string> GenerateUniqueSignatureForEA( ea_t
 			return std::unexpected( "Aborted" );
 		}
 
-		insn_t instruction;
-		auto currentInstructionLength = decode_insn( &instruction, currentAddress );
+		// Instructions the wildcard bitmap knows are added without decoding them
+		uint8_t operandOffset = 0, operandLength = 0;
+		const auto bitmapInstructionLength = wildcardOperands ? GetBitmapInstructionLength( currentAddress, operandTypeBitmask ) : 0;
+		auto currentInstructionLength = bitmapInstructionLength > 0 ? static_cast<int>( bitmapInstructionLength ) : DecodeInstruction( currentAddress, operandTypeBitmask, &operandOffset, &operandLength );
 		if( currentInstructionLength <= 0 ) {
 			if( signature.empty( ) ) {
 				return std::unexpected( "Failed to decode first instruction" );
@@ -161,202 +985,797 @@ static std::expected<Signature, std::string> GenerateUniqueSignatureForEA( ea_t
 		}
 		sigPartLength += currentInstructionLength;
 
+		const auto previousSignatureSize = signature.size( );
+
+		if( bitmapInstructionLength > 0 ) {
+			AddInstructionSliceToSignature( signature, currentAddress, bitmapInstructionLength );
+		}
+		else {
+			if( !wildcardOperands ) {
+				// No operand, add all bytes
+				operandLength = 0;
+			}
+			AddInstructionToSignature( signature, currentAddress, currentInstructionLength, operandOffset, operandLength );
+		}
+
+		const auto wasInitialized = candidates.isInitialized;
+		if( UpdateSignatureCandidates( candidates, signature, previousSignatureSize, wildcardOperands, operandTypeBitmask ) ) {
+			// Remove wildcards at end for output
+			TrimSignature( signature );
+
+			// Return the signature we generated
+			return signature;
+		}
+
+		// Candidates only ever shrink, so comparing them once against the rest of the function shows if any can never be excluded
+		if( !wasInitialized && candidates.isInitialized && !continueOutsideOfFunction && currentFunction ) {
+			// Decoded without a length limit, so the window always ends with the function or the code, never at TargetStop::MaximumLength
+			const auto target = DecodeSignatureTarget( ea, wildcardOperands, continueOutsideOfFunction, operandTypeBitmask, SIZE_MAX );
+			if( target.has_value( ) ) {
+				const auto indistinguishableCandidates = FindIndistinguishableCandidates( target.value( ), candidates.addresses );
+				if( !indistinguishableCandidates.empty( ) ) {
+					return std::unexpected( FormatIndistinguishableCandidates( target.value( ), indistinguishableCandidates ) );
+				}
+			}
+		}
+		currentAddress += currentInstructionLength;
+
+		// Break if we leave function
+		if( !continueOutsideOfFunction && currentFunction && get_func( currentAddress ) != currentFunction ) {
+			return std::unexpected( "Signature left function scope" );
+		}
+
+	}
+	return std::unexpected( "Unknown" );
+}
+
+// Same search as GenerateUniqueSignatureForEA on pre decoded bytes, safe to run on worker threads.
+// lengthBound can be lowered by other threads while the search runs
+static std::expected<Signature, std::string> FindUniqueSignaturePrefix( const SignatureTarget& target, bool wildcardOperands, uint32_t operandTypeBitmask, const std::atomic<bool>& isCancelled, const std::atomic<size_t>* lengthBound = nullptr ) {
+	Signature signature;
+	SignatureCandidates candidates;
+	for( const auto instructionEnd : target.instructionEnds ) {
+		if( isCancelled ) {
+			return std::unexpected( "Aborted" );
+		}
+
+		if( lengthBound && signature.size( ) > lengthBound->load( std::memory_order_relaxed ) ) {
+			return std::unexpected( "Signature exceeded maximum length" );
+		}
+
+		const auto previousSignatureSize = signature.size( );
+		signature.Append( target.signature, previousSignatureSize, instructionEnd - previousSignatureSize );
+		const auto wasInitialized = candidates.isInitialized;
+		if( UpdateSignatureCandidates( candidates, signature, previousSignatureSize, wildcardOperands, operandTypeBitmask ) ) {
+			TrimSignature( signature );
+			return signature;
+		}
+
+		// Give up before growing through the whole window if a candidate matches all of it
+		if( !wasInitialized && candidates.isInitialized ) {
+			const auto indistinguishableCandidates = FindIndistinguishableCandidates( target, candidates.addresses );
+			if( !indistinguishableCandidates.empty( ) ) {
+				return std::unexpected( FormatIndistinguishableCandidates( target, indistinguishableCandidates ) );
+			}
+		}
+	}
+	return std::unexpected( GetTargetStopReason( target.stop ) );
+}
+
+// Function for code selection
+static std::expected<Signature, std::string> GenerateSignatureForEARange( ea_t eaStart, ea_t eaEnd, bool wildcardOperands, uint32_t operandTypeBitmask ) {
+	if( eaStart == BADADDR || eaEnd == BADADDR ) {
+		return std::unexpected( "Invalid address" );
+	}
+
+	Signature signature;
+	size_t sigPartLength = 0;
+
+	// Copy data section, no wildcards
+	if( !is_code( get_flags( eaStart ) ) ) {
+		AddBytesToSignature( signature, eaStart, eaEnd - eaStart, false );
+		return signature;
+	}
+
+	auto currentAddress = eaStart;
+	while( true ) {
+		// Handle IDA "cancel" event
+		if( user_cancelled( ) ) {
+			return std::unexpected( "Aborted" );
+		}
+
 		uint8_t operandOffset = 0, operandLength = 0;
-		if( wildcardOperands && GetOperand( instruction, &operandOffset, &operandLength, operandTypeBitmask ) && operandLength > 0 ) {
-			// Add opcodes
-			AddBytesToSignature( signature, currentAddress, operandOffset, false );
-			// Wildcards for operands
-			AddBytesToSignature( signature, currentAddress + operandOffset, operandLength, true );
-			// If the operand is on the "left side", add the operator from the "right side"
-			if( operandOffset == 0 ) {
-				AddBytesToSignature( signature, currentAddress + operandLength, currentInstructionLength - operandLength, false );
+		auto currentInstructionLength = DecodeInstruction( currentAddress, operandTypeBitmask, &operandOffset, &operandLength );
+		if( currentInstructionLength <= 0 ) {
+			if( signature.empty( ) ) {
+				return std::unexpected( "Failed to decode first instruction" );
 			}
+
+			msg( "Signature reached end of executable code @ %I64X\n", currentAddress );
+			// If we have some bytes left, add them
+			if( currentAddress < eaEnd ) {
+				AddBytesToSignature( signature, currentAddress, eaEnd - currentAddress, false );
+			}
+			TrimSignature( signature );
+			return signature;
 		}
-		else {
+
+		sigPartLength += currentInstructionLength;
+
+		if( !wildcardOperands ) {
 			// No operand, add all bytes
-			AddBytesToSignature( signature, currentAddress, currentInstructionLength, false );
+			operandLength = 0;
+		}
+		AddInstructionToSignature( signature, currentAddress, currentInstructionLength, operandOffset, operandLength );
+		currentAddress += currentInstructionLength;
+
+		if( currentAddress >= eaEnd ) {
+
+			TrimSignature( signature );
+			return signature;
+		}
+	}
+	return std::unexpected( "Unknown" );
+}
+
+void PrintSignatureForEA( const std::expected<Signature, std::string>& signature, ea_t ea, SignatureType sigType ) {
+	if( !signature.has_value( ) ) {
+		msg( "Error: %s\n", signature.error( ).c_str( ) );
+		return;
+	}
+	const auto signatureStr = FormatSignature( signature.value( ), sigType );
+	msg( "Signature for %I64X: %s\n", ea, signatureStr.c_str( ) );
+	if( !SetClipboardText( signatureStr ) ) {
+		msg( "Failed to copy to clipboard!" );
+	}
+}
+
+// Collects the shortest signatures without a lock. Every search writes only its own slot, the length of the worst
+// signature that still makes the list is published as a bound so searches that can no longer make it stop early.
+// Equally long signatures are still searched, they can win by order
+class TopSignatures {
+public:
+	// The last bucket of lengthCounts counts everything longer than maxSignatureLength
+	TopSignatures( size_t slotCount, size_t capacity, size_t maxSignatureLength ) : slots( slotCount ), capacity( capacity ), lengthCounts( maxSignatureLength + 2 ), lengthBound( maxSignatureLength ), shortestLength( maxSignatureLength + 1 ) {
+	}
+
+	// Only one thread may write a slot. order breaks ties between equally long signatures, so the result does not depend on thread timing
+	void Add( size_t slot, size_t order, ea_t ea, Signature&& signature ) {
+		foundCount++;
+
+		// The last instruction can exceed the bound, such a signature only counts while the list is not full
+		const auto length = signature.size( );
+		lengthCounts[std::min( length, lengthCounts.size( ) - 1 )]++;
+		LowerAtomic( shortestLength, length );
+
+		// The bound is the length of the capacity-th shortest signature found so far
+		size_t count = 0;
+		for( size_t i = 0; i + 1 < lengthCounts.size( ) && i <= lengthBound.load( std::memory_order_relaxed ); i++ ) {
+			count += lengthCounts[i].load( std::memory_order_relaxed );
+			if( count >= capacity ) {
+				LowerAtomic( lengthBound, i );
+				break;
+			}
+		}
+
+		if( length <= lengthBound || count < capacity ) {
+			slots[slot] = Entry{ length, order, ea, std::move( signature ) };
+		}
+	}
+
+	const std::atomic<size_t>& GetLengthBound( ) const {
+		return lengthBound;
+	}
+
+	size_t GetShortestLength( ) const {
+		return shortestLength;
+	}
+
+	size_t GetFoundCount( ) const {
+		return foundCount;
+	}
+
+	// Only call once all searches are done
+	std::vector<std::tuple<ea_t, Signature>> TakeSorted( ) {
+		std::vector<Entry*> entries;
+		for( auto& slot : slots ) {
+			if( slot.has_value( ) ) {
+				entries.push_back( &slot.value( ) );
+			}
+		}
+		const auto resultCount = std::min( capacity, entries.size( ) );
+		std::ranges::partial_sort( entries, entries.begin( ) + resultCount, []( const Entry* a, const Entry* b ) { return IsBetter( *a, *b ); } );
+
+		std::vector<std::tuple<ea_t, Signature>> result;
+		result.reserve( resultCount );
+		for( size_t i = 0; i < resultCount; i++ ) {
+			result.emplace_back( entries[i]->ea, std::move( entries[i]->signature ) );
+		}
+		slots.clear( );
+		return result;
+	}
+
+private:
+	struct Entry {
+		size_t length;
+		size_t order;
+		ea_t ea;
+		Signature signature;
+	};
+
+	static bool IsBetter( const Entry& a, const Entry& b ) {
+		return a.length != b.length ? a.length < b.length : a.order < b.order;
+	}
+
+	static void LowerAtomic( std::atomic<size_t>& value, size_t newValue ) {
+		auto current = value.load( );
+		while( newValue < current && !value.compare_exchange_weak( current, newValue ) ) {
+		}
+	}
+
+	std::vector<std::optional<Entry>> slots;
+	size_t capacity;
+	std::vector<std::atomic<size_t>> lengthCounts;
+	std::atomic<size_t> lengthBound;
+	std::atomic<size_t> shortestLength;
+	std::atomic<size_t> foundCount = 0;
+};
+
+// Returns the number of code xrefs, xrefSignatures receives the shortest topCount signatures sorted by length
+static size_t FindXRefs( ea_t ea, bool wildcardOperands, bool continueOutsideOfFunction, std::vector<std::tuple<ea_t, Signature>>& xrefSignatures, size_t maxSignatureLength, uint32_t operandTypeBitmask, size_t topCount ) {
+	xrefblk_t xref{};
+
+	// Collect code xrefs, skip data refs, xref.iscode is not what we want though
+	std::vector<ea_t> xrefAddresses;
+	for( auto xref_ok = xref.first_to( ea, XREF_FAR ); xref_ok; xref_ok = xref.next_to( ) ) {
+		if( !is_code( get_flags( xref.from ) ) ) {
+			continue;
+		}
+		xrefAddresses.push_back( xref.from );
+	}
+
+	if( xrefAddresses.empty( ) || !PrepareSearchCaches( wildcardOperands, operandTypeBitmask ) ) {
+		return xrefAddresses.size( );
+	}
+
+	// Decoding needs IDA, so do it here for all xrefs first
+	std::vector<std::expected<SignatureTarget, std::string>> targets;
+	targets.reserve( xrefAddresses.size( ) );
+	for( size_t i = 0; i < xrefAddresses.size( ); i++ ) {
+		if( user_cancelled( ) ) {
+			return xrefAddresses.size( );
+		}
+		replace_wait_box( "Decoding xref %llu of %llu...", i + 1, xrefAddresses.size( ) );
+		targets.push_back( DecodeSignatureTarget( xrefAddresses[i], wildcardOperands, continueOutsideOfFunction, operandTypeBitmask, maxSignatureLength ) );
+	}
+
+	TopSignatures topSignatures( targets.size( ), topCount, maxSignatureLength );
+
+	std::atomic<bool> isCancelled = false;
+	std::atomic<bool> isFinished = false;
+	std::atomic<size_t> doneCount = 0;
+
+	std::thread searchThread( [&] {
+		GetWorkerPool( ).ParallelFor( targets.size( ), [&]( size_t i ) {
+			if( targets[i].has_value( ) ) {
+				auto signature = FindUniqueSignaturePrefix( targets[i].value( ), wildcardOperands, operandTypeBitmask, isCancelled, &topSignatures.GetLengthBound( ) );
+				if( signature.has_value( ) ) {
+					topSignatures.Add( i, i, xrefAddresses[i], std::move( signature.value( ) ) );
+				}
+			}
+			doneCount++;
+		} );
+		isFinished = true;
+	} );
+
+	while( !isFinished ) {
+		std::this_thread::sleep_for( std::chrono::milliseconds( 100 ) );
+
+		// Instantly abort
+		if( user_cancelled( ) ) {
+			isCancelled = true;
+		}
+
+		const auto processedCount = doneCount.load( );
+		const auto shortestLength = topSignatures.GetShortestLength( );
+		replace_wait_box( "Processing xref %llu of %llu (%0.1f%%)...\n\nSuitable Signatures: %llu\nShortest Signature: %llu Bytes", processedCount, targets.size( ), ( static_cast<float>( processedCount ) / targets.size( ) ) * 100.0f, topSignatures.GetFoundCount( ), ( shortestLength <= maxSignatureLength ? shortestLength : 0 ) );
+	}
+	searchThread.join( );
+
+	xrefSignatures = topSignatures.TakeSorted( );
+	return xrefAddresses.size( );
+}
+
+static void PrintXRefSignaturesForEA( ea_t ea, const std::vector<std::tuple<ea_t, Signature>>& xrefSignatures, size_t xrefCount, SignatureType sigType, size_t topCount ) {
+	if( xrefSignatures.empty( ) ) {
+		msg( "No XREFs have been found for your address\n" );
+		return;
+	}
+
+	auto topLength = std::min( topCount, xrefSignatures.size( ) );
+	msg( "Top %llu Signatures out of %llu xrefs for %I64X:\n", topLength, xrefCount, ea );
+	for( size_t i = 0; i < topLength; i++ ) {
+		const auto& [originAddress, signature] = xrefSignatures[i];
+		const auto signatureStr = FormatSignature( signature, sigType );
+		msg( "XREF Signature #%i @ %I64X: %s\n", i + 1, originAddress, signatureStr.c_str( ) );
+
+		// Copy first signature only
+		if( i == 0 ) {
+			SetClipboardText( signatureStr );
+		}
+	}
+}
+
+// Unique signature that starts somewhere else than the address it is meant for
+struct OffsetSignature {
+	ea_t ea = BADADDR; // Where the signature starts
+	Signature signature;
+};
+
+static void PrintOffsetSignatureForEA( const std::expected<OffsetSignature, std::string>& result, ea_t ea, SignatureType sigType ) {
+	if( !result.has_value( ) ) {
+		msg( "Error: %s\n", result.error( ).c_str( ) );
+		return;
+	}
+
+	const auto& [signatureEA, signature] = result.value( );
+	const auto signatureStr = FormatSignature( signature, sigType );
+	const auto offsetStr = signatureEA <= ea ? std::format( "+0x{:X}", ea - signatureEA ) : std::format( "-0x{:X}", signatureEA - ea );
+	msg( "Signature for %I64X @ %I64X, offset %s: %s\n", ea, signatureEA, offsetStr.c_str( ), signatureStr.c_str( ) );
+	if( !SetClipboardText( signatureStr ) ) {
+		msg( "Failed to copy to clipboard!" );
+	}
+}
+
+// Shortest unique signature starting at any instruction of the function containing ea.
+// If the suffix array is built, it gives a lower bound for the length at every start. Starts are searched in order
+// of that bound until no remaining one can beat or tie the best signature
+static std::expected<OffsetSignature, std::string> FindShortestSignatureInFunction( ea_t ea, bool wildcardOperands, bool continueOutsideOfFunction, uint32_t operandTypeBitmask, size_t maxSignatureLength ) {
+	const auto function = get_func( ea );
+	if( function == nullptr ) {
+		return std::unexpected( "Address is not inside a function" );
+	}
+
+	if( !PrepareSearchCaches( wildcardOperands, operandTypeBitmask ) ) {
+		return std::unexpected( "Aborted" );
+	}
+
+	// Only the suffix array has the bounds, the q-gram index or no index at all means searching every start
+	const auto hasLowerBounds = CodeIndex.IsBuilt( );
+	if( !hasLowerBounds ) {
+		msg( "%s, searching every instruction of the function\n", UseSearchIndex ? "Q-gram index has no length bounds" : "Search index disabled" );
+	}
+
+	struct Start {
+		ea_t ea;
+		size_t lowerBound;
+		size_t distance; // To ea, prefers starts closer to the target between equally long signatures
+	};
+	std::vector<Start> starts;
+	func_item_iterator_t functionItems;
+	for( auto ok = functionItems.set( function ); ok; ok = functionItems.next_code( ) ) {
+		const auto startEA = functionItems.current( );
+		const auto lowerBound = hasLowerBounds ? std::max<size_t>( CodeIndex.GetMinimalUniqueLength( startEA ), 1 ) : 1;
+		if( lowerBound > maxSignatureLength ) {
+			continue;
+		}
+		starts.push_back( { startEA, lowerBound, static_cast<size_t>( startEA < ea ? ea - startEA : startEA - ea ) } );
+	}
+	std::ranges::sort( starts, []( const Start& a, const Start& b ) { return a.lowerBound != b.lowerBound ? a.lowerBound < b.lowerBound : a.distance < b.distance; } );
+
+	TopSignatures bestSignature( starts.size( ), 1, maxSignatureLength );
+	std::atomic<bool> isCancelled = false;
+	std::atomic<size_t> doneCount = 0;
+
+	// Decode and search in batches, so starts that can not beat the best signature are never decoded
+	constexpr size_t batchSize = 256;
+	size_t nextStart = 0;
+	while( nextStart < starts.size( ) && starts[nextStart].lowerBound <= bestSignature.GetLengthBound( ) && !isCancelled ) {
+		std::vector<std::pair<size_t, SignatureTarget>> targets;
+		for( ; nextStart < starts.size( ) && targets.size( ) < batchSize; nextStart++ ) {
+			const auto lengthBound = bestSignature.GetLengthBound( ).load( );
+			if( starts[nextStart].lowerBound > lengthBound ) {
+				break;
+			}
+
+			auto target = DecodeSignatureTarget( starts[nextStart].ea, wildcardOperands, continueOutsideOfFunction, operandTypeBitmask, lengthBound );
+			if( target.has_value( ) ) {
+				targets.emplace_back( nextStart, std::move( target.value( ) ) );
+			}
 		}
 
-		auto currentSig = BuildIDASignatureString( signature );
-		if( IsSignatureUnique( currentSig ) ) {
-			// Remove wildcards at end for output
-			TrimSignature( signature );
+		std::atomic<bool> isFinished = false;
+		std::thread searchThread( [&] {
+			GetWorkerPool( ).ParallelFor( targets.size( ), [&]( size_t i ) {
+				const auto& [startIndex, target] = targets[i];
+				if( starts[startIndex].lowerBound <= bestSignature.GetLengthBound( ) ) {
+					auto signature = FindUniqueSignaturePrefix( target, wildcardOperands, operandTypeBitmask, isCancelled, &bestSignature.GetLengthBound( ) );
+					if( signature.has_value( ) ) {
+						bestSignature.Add( startIndex, starts[startIndex].distance, target.ea, std::move( signature.value( ) ) );
+					}
+				}
+				doneCount++;
+			} );
+			isFinished = true;
+		} );
+
+		while( !isFinished ) {
+			std::this_thread::sleep_for( std::chrono::milliseconds( 100 ) );
+			if( user_cancelled( ) ) {
+				isCancelled = true;
+			}
 
-			// Return the signature we generated
-			return signature;
+			const auto shortestLength = bestSignature.GetShortestLength( );
+			replace_wait_box( "Searched %llu of %llu instructions...\n\nShortest Signature: %llu Bytes", doneCount.load( ), starts.size( ), ( shortestLength <= maxSignatureLength ? shortestLength : 0 ) );
 		}
-		currentAddress += currentInstructionLength;
+		searchThread.join( );
+	}
 
-		// Break if we leave function
-		if( !continueOutsideOfFunction && currentFunction && get_func( currentAddress ) != currentFunction ) {
-			return std::unexpected( "Signature left function scope" );
-		}
+	if( isCancelled ) {
+		return std::unexpected( "Aborted" );
+	}
 
+	auto result = bestSignature.TakeSorted( );
+	if( result.empty( ) ) {
+		return std::unexpected( "No unique signature found in function" );
 	}
-	return std::unexpected( "Unknown" );
+	msg( "Searched %llu of %llu instructions for the shortest signature\n", doneCount.load( ), starts.size( ) );
+
+	auto& [signatureEA, signature] = result.front( );
+	return OffsetSignature{ signatureEA, std::move( signature ) };
 }
 
-// Function for code selection
-static std::expected<Signature, std::string> GenerateSignatureForEARange( ea_t eaStart, ea_t eaEnd, bool wildcardOperands, uint32_t operandTypeBitmask ) {
-	if( eaStart == BADADDR || eaEnd == BADADDR ) {
+// Grows the signature forward and backward from ea, at every step in the direction that leaves fewer candidates
+static std::expected<OffsetSignature, std::string> GenerateBidirectionalSignatureForEA( ea_t ea, bool wildcardOperands, bool continueOutsideOfFunction, uint32_t operandTypeBitmask, size_t maxSignatureLength ) {
+	if( ea == BADADDR ) {
 		return std::unexpected( "Invalid address" );
 	}
 
-	Signature signature;
-	size_t sigPartLength = 0;
+	if( !is_code( get_flags( ea ) ) ) {
+		return std::unexpected( "Can not create code signature for data" );
+	}
 
-	// Copy data section, no wildcards
-	if( !is_code( get_flags( eaStart ) ) ) {
-		AddBytesToSignature( signature, eaStart, eaEnd - eaStart, false );
-		return signature;
+	if( !PrepareImageSnapshot( ) ) {
+		return std::unexpected( "Aborted" );
 	}
 
-	auto currentAddress = eaStart;
-	while( true ) {
-		// Handle IDA "cancel" event
-		if( user_cancelled( ) ) {
-			return std::unexpected( "Aborted" );
+	const auto currentFunction = get_func( ea );
+	const auto currentChunk = get_fchunk( ea );
+
+	// Appends the instruction at address, returns its length
+	const auto decodeInstruction = [&]( ea_t address, Signature& piece ) -> int {
+		uint8_t operandOffset = 0, operandLength = 0;
+		const auto instructionLength = DecodeInstruction( address, operandTypeBitmask, &operandOffset, &operandLength );
+		if( instructionLength <= 0 ) {
+			return 0;
+		}
+		if( !wildcardOperands ) {
+			operandLength = 0;
 		}
+		AddInstructionToSignature( piece, address, instructionLength, operandOffset, operandLength );
+		return instructionLength;
+	};
+
+	// Next instruction after the signature, empty if there is none
+	const auto decodeForward = [&]( ea_t address, Signature& piece ) {
+		if( !continueOutsideOfFunction && currentFunction && get_func( address ) != currentFunction ) {
+			return;
+		}
+		decodeInstruction( address, piece );
+	};
 
+	// Instruction before the signature, follows the code flow first and falls back to the previous head of the chunk
+	const auto decodeBackward = [&]( ea_t address, Signature& piece ) -> ea_t {
+		const auto lowerLimit = !continueOutsideOfFunction && currentChunk ? currentChunk->start_ea : 0;
 		insn_t instruction;
-		auto currentInstructionLength = decode_insn( &instruction, currentAddress );
-		if( currentInstructionLength <= 0 ) {
-			if( signature.empty( ) ) {
-				return std::unexpected( "Failed to decode first instruction" );
+		auto previousAddress = decode_prev_insn( &instruction, address );
+		if( previousAddress == BADADDR ) {
+			previousAddress = prev_head( address, lowerLimit );
+			if( previousAddress == BADADDR || !is_code( get_flags( previousAddress ) ) ) {
+				return BADADDR;
 			}
+		}
+		if( previousAddress < lowerLimit ) {
+			return BADADDR;
+		}
 
-			msg( "Signature reached end of executable code @ %I64X\n", currentAddress );
-			// If we have some bytes left, add them
-			if( currentAddress < eaEnd ) {
-				AddBytesToSignature( signature, currentAddress, eaEnd - currentAddress, false );
+		Signature previousPiece;
+		if( decodeInstruction( previousAddress, previousPiece ) <= 0 || previousAddress + previousPiece.size( ) != address ) {
+			return BADADDR;
+		}
+		piece = std::move( previousPiece );
+		return previousAddress;
+	};
+
+	Signature signature;
+	size_t targetOffset = 0;
+	ea_t backwardEA = ea;
+	ea_t forwardEA = ea;
+
+	// The target instruction itself, needs one full scan
+	decodeForward( forwardEA, signature );
+	if( signature.empty( ) ) {
+		return std::unexpected( "Failed to decode first instruction" );
+	}
+	forwardEA += signature.size( );
+	auto candidates = FindSignatureOccurences( CompileSignature( signature ) );
+
+	// Candidates are tracked as target addresses
+	const auto countMatches = [&]( const Signature& piece, ptrdiff_t pieceOffset, std::vector<ea_t>* survivors ) {
+		size_t matchCount = 0;
+		for( const auto candidate : candidates ) {
+			if( pieceOffset < 0 && candidate < static_cast<ea_t>( -pieceOffset ) ) {
+				continue;
+			}
+			if( DoesSignatureMatchAt( piece, candidate + pieceOffset ) ) {
+				matchCount++;
+				if( survivors ) {
+					survivors->push_back( candidate );
+				}
 			}
-			TrimSignature( signature );
-			return signature;
 		}
+		return matchCount;
+	};
 
-		sigPartLength += currentInstructionLength;
+	while( candidates.size( ) > 1 ) {
+		if( user_cancelled( ) ) {
+			return std::unexpected( "Aborted" );
+		}
 
-		uint8_t operandOffset = 0, operandLength = 0;
-		if( wildcardOperands && GetOperand( instruction, &operandOffset, &operandLength, operandTypeBitmask ) && operandLength > 0 ) {
-			// Add opcodes
-			AddBytesToSignature( signature, currentAddress, operandOffset, false );
-			// Wildcards for operands
-			AddBytesToSignature( signature, currentAddress + operandOffset, operandLength, true );
-			// If the operand is on the "left side", add the operator from the "right side"
-			if( operandOffset == 0 ) {
-				AddBytesToSignature( signature, currentAddress + operandLength, currentInstructionLength - operandLength, false );
-			}
+		if( signature.size( ) > maxSignatureLength ) {
+			return std::unexpected( "Signature exceeded maximum length" );
 		}
-		else {
-			// No operand, add all bytes
-			AddBytesToSignature( signature, currentAddress, currentInstructionLength, false );
+
+		Signature forwardPiece, backwardPiece;
+		decodeForward( forwardEA, forwardPiece );
+		const auto previousEA = decodeBackward( backwardEA, backwardPiece );
+		if( forwardPiece.empty( ) && backwardPiece.empty( ) ) {
+			return std::unexpected( "Signature not unique" );
 		}
-		currentAddress += currentInstructionLength;
 
-		if( currentAddress >= eaEnd ) {
+		const auto forwardOffset = static_cast<ptrdiff_t>( signature.size( ) - targetOffset );
+		const auto backwardOffset = -static_cast<ptrdiff_t>( targetOffset + backwardPiece.size( ) );
+		const auto forwardCount = forwardPiece.empty( ) ? SIZE_MAX : countMatches( forwardPiece, forwardOffset, nullptr );
+		const auto backwardCount = backwardPiece.empty( ) ? SIZE_MAX : countMatches( backwardPiece, backwardOffset, nullptr );
 
-			TrimSignature( signature );
-			return signature;
+		// Fewer candidates wins, then fewer bytes, then forward like the normal generator
+		const auto growBackward = backwardCount < forwardCount || ( backwardCount == forwardCount && backwardPiece.size( ) < forwardPiece.size( ) );
+
+		std::vector<ea_t> survivors;
+		if( growBackward ) {
+			countMatches( backwardPiece, backwardOffset, &survivors );
+			signature.Prepend( backwardPiece );
+			targetOffset += backwardPiece.size( );
+			backwardEA = previousEA;
+		}
+		else {
+			countMatches( forwardPiece, forwardOffset, &survivors );
+			signature.Append( forwardPiece, 0, forwardPiece.size( ) );
+			forwardEA += forwardPiece.size( );
 		}
+		candidates = std::move( survivors );
 	}
-	return std::unexpected( "Unknown" );
+
+	if( candidates.empty( ) ) {
+		return std::unexpected( "Signature does not match the target" );
+	}
+
+	// Wildcards on either end don't add anything
+	TrimSignature( signature );
+	size_t leadingWildcards = 0;
+	while( leadingWildcards < signature.size( ) && signature.IsWildcard( leadingWildcards ) ) {
+		leadingWildcards++;
+	}
+	signature.EraseFront( leadingWildcards );
+	targetOffset -= leadingWildcards;
+
+	return OffsetSignature{ ea - targetOffset, std::move( signature ) };
 }
 
-void PrintSignatureForEA( const std::expected<Signature, std::string>& signature, ea_t ea, SignatureType sigType ) {
+static void PrintSelectedCode( ea_t start, ea_t end, SignatureType sigType, bool wildcardOperands, uint32_t operandBitmask ) {
+	const auto selectionSize = end - start;
+	// Create signature of fixed size from selection
+
+	auto signature = GenerateSignatureForEARange( start, end, wildcardOperands, operandBitmask );
 	if( !signature.has_value( ) ) {
 		msg( "Error: %s\n", signature.error( ).c_str( ) );
 		return;
 	}
+
 	const auto signatureStr = FormatSignature( signature.value( ), sigType );
-	msg( "Signature for %I64X: %s\n", ea, signatureStr.c_str( ) );
-	if( !SetClipboardText( signatureStr ) ) {
-		msg( "Failed to copy to clipboard!" );
-	}
+	msg( "Code for %I64X-%I64X: %s\n", start, end, signatureStr.c_str( ) );
+	SetClipboardText( signatureStr );
 }
 
-static void FindXRefs( ea_t ea, bool wildcardOperands, bool continueOutsideOfFunction, std::vector<std::tuple<ea_t, Signature>>& xrefSignatures, size_t maxSignatureLength, uint32_t operandTypeBitmask ) {
-	xrefblk_t xref{};
-
-	// Count code xrefs
-	size_t xrefCount = 0;
-	for( auto xref_ok = xref.first_to( ea, XREF_FAR ); xref_ok; xref_ok = xref.next_to( ) ) {
-		if( !is_code( get_flags( xref.from ) ) ) {
-			continue;
-		}
-		++xrefCount;
+static void GenerateSignaturesForFunctions( const std::string& nameFilter, const std::string& segmentFilter, const std::string& outputPath, SignatureType sigType, bool wildcardOperands, bool continueOutsideOfFunction, uint32_t operandTypeBitmask ) {
+	std::regex nameRegex;
+	try {
+		nameRegex = std::regex( nameFilter );
+	}
+	catch( const std::regex_error& ) {
+		msg( "Invalid name filter \"%s\"\n", nameFilter.c_str( ) );
+		return;
 	}
 
-	size_t shortestSignatureLength = maxSignatureLength + 1;
-
-	size_t i = 0;
-	for( auto xref_ok = xref.first_to( ea, XREF_FAR ); xref_ok; xref_ok = xref.next_to( ), ++i ) {
+	std::ofstream output( outputPath );
+	if( !output ) {
+		msg( "Failed to open %s\n", outputPath.c_str( ) );
+		return;
+	}
 
-		// Instantly abort
-		if( user_cancelled( ) ) {
-			break;
-		}
+	const auto startTime = std::chrono::steady_clock::now( );
 
-		// Skip data refs, xref.iscode is not what we want though
-		if( !is_code( get_flags( xref.from ) ) ) {
+	// Collect functions
+	std::vector<func_t*> functions;
+	std::vector<qstring> functionNames;
+	for( size_t i = 0; i < get_func_qty( ); i++ ) {
+		const auto function = getn_func( i );
+		if( function == nullptr ) {
 			continue;
 		}
 
-		replace_wait_box( "Processing xref %llu of %llu (%0.1f%%)...\n\nSuitable Signatures: %llu\nShortest Signature: %llu Bytes", i + 1, xrefCount, ( static_cast<float>( i ) / xrefCount ) * 100.0f, xrefSignatures.size( ), ( shortestSignatureLength <= maxSignatureLength ? shortestSignatureLength : 0 ) );
-
-		// Genreate signature for xref
-		auto signature = GenerateUniqueSignatureForEA( xref.from, wildcardOperands, continueOutsideOfFunction, operandTypeBitmask, maxSignatureLength, false );
-		if( !signature.has_value( ) ) {
+		qstring functionName;
+		get_func_name( &functionName, function->start_ea );
+		if( !nameFilter.empty( ) && !std::regex_search( functionName.c_str( ), nameRegex ) ) {
 			continue;
 		}
 
-		// Update for statistics
-		if( signature.value( ).size( ) < shortestSignatureLength ) {
-			shortestSignatureLength = signature.value( ).size( );
+		if( !segmentFilter.empty( ) ) {
+			qstring segmentName;
+			const auto segment = getseg( function->start_ea );
+			if( segment == nullptr || get_segm_name( &segmentName, segment ) <= 0 || segmentName != segmentFilter.c_str( ) ) {
+				continue;
+			}
 		}
 
-		xrefSignatures.push_back( std::make_pair( xref.from, signature.value( ) ) );
+		functions.push_back( function );
+		functionNames.push_back( functionName );
 	}
 
-	// Sort signatures by length
-	std::ranges::sort( xrefSignatures, []( const auto& a, const auto& b ) -> bool { return std::get<1>( a ).size( ) < std::get<1>( b ).size( ); } );
-}
+	if( functions.empty( ) ) {
+		msg( "No functions match the filter\n" );
+		return;
+	}
 
-static void PrintXRefSignaturesForEA( ea_t ea, const std::vector<std::tuple<ea_t, Signature>>& xrefSignatures, SignatureType sigType, size_t topCount ) {
-	if( xrefSignatures.empty( ) ) {
-		msg( "No XREFs have been found for your address\n" );
+	if( !PrepareSearchCaches( wildcardOperands, operandTypeBitmask ) || !PrepareFunctionHashes( wildcardOperands, operandTypeBitmask ) ) {
+		msg( "Aborted\n" );
 		return;
 	}
 
-	auto topLength = std::min( topCount, xrefSignatures.size( ) );
-	msg( "Top %llu Signatures out of %llu xrefs for %I64X:\n", topLength, xrefSignatures.size( ), ea );
-	for( size_t i = 0; i < topLength; i++ ) {
-		const auto& [originAddress, signature] = xrefSignatures[i];
-		const auto signatureStr = FormatSignature( signature, sigType );
-		msg( "XREF Signature #%i @ %I64X: %s\n", i + 1, originAddress, signatureStr.c_str( ) );
+	// Functions identical to others can not get a signature of their own, search their xrefs instead.
+	// Jobs of one function are adjacent, the function is done once all of them are
+	struct SearchJob {
+		size_t functionIndex;
+		std::expected<SignatureTarget, std::string> target;
+	};
+	constexpr size_t maxXRefsPerFunction = 16;
+
+	// Decoding needs IDA, so do it here for all functions first
+	std::vector<SearchJob> jobs;
+	std::vector<size_t> firstJobs( functions.size( ) + 1 );
+	std::vector<std::string> identicalReasons( functions.size( ) );
+	jobs.reserve( functions.size( ) );
+	for( size_t i = 0; i < functions.size( ); i++ ) {
+		if( ( i % 256 ) == 0 ) {
+			if( user_cancelled( ) ) {
+				msg( "Aborted\n" );
+				return;
+			}
+			replace_wait_box( "Decoding function %llu of %llu...", i + 1, functions.size( ) );
+		}
 
-		// Copy first signature only
-		if( i == 0 ) {
-			SetClipboardText( signatureStr );
+		firstJobs[i] = jobs.size( );
+		const auto ea = functions[i]->start_ea;
+		if( const auto identicalFunctions = FindIdenticalFunctions( ea, wildcardOperands, continueOutsideOfFunction, operandTypeBitmask ); !identicalFunctions.empty( ) ) {
+			identicalReasons[i] = FormatIdenticalFunctions( identicalFunctions );
+
+			xrefblk_t xref{};
+			size_t xrefCount = 0;
+			for( auto xref_ok = xref.first_to( ea, XREF_FAR ); xref_ok && xrefCount < maxXRefsPerFunction; xref_ok = xref.next_to( ) ) {
+				if( is_code( get_flags( xref.from ) ) ) {
+					jobs.push_back( { i, DecodeSignatureTarget( xref.from, wildcardOperands, continueOutsideOfFunction, operandTypeBitmask, 250 ) } );
+					xrefCount++;
+				}
+			}
+			continue;
+		}
+		jobs.push_back( { i, DecodeSignatureTarget( ea, wildcardOperands, continueOutsideOfFunction, operandTypeBitmask, 1000 ) } );
+	}
+	firstJobs[functions.size( )] = jobs.size( );
+
+	// Search on the worker pool, while this thread keeps the UI responsive and streams finished results to the file
+	std::vector<std::expected<Signature, std::string>> jobResults( jobs.size( ) );
+	std::vector<std::expected<Signature, std::string>> results( functions.size( ) );
+	std::vector<ea_t> resultEAs( functions.size( ), BADADDR );
+	const auto isDone = std::make_unique<std::atomic<bool>[]>( functions.size( ) );
+	const auto pendingJobs = std::make_unique<std::atomic<size_t>[]>( functions.size( ) );
+	std::atomic<bool> isCancelled = false;
+	std::atomic<bool> isFinished = false;
+	std::atomic<size_t> doneCount = 0;
+
+	// Called by whichever thread finishes the last job of a function
+	const auto finishFunction = [&]( size_t functionIndex ) {
+		auto& result = results[functionIndex];
+		if( identicalReasons[functionIndex].empty( ) ) {
+			const auto job = firstJobs[functionIndex];
+			result = std::move( jobResults[job] );
+			resultEAs[functionIndex] = functions[functionIndex]->start_ea;
+		}
+		else {
+			result = std::unexpected( identicalReasons[functionIndex] );
+			for( auto job = firstJobs[functionIndex]; job < firstJobs[functionIndex + 1]; job++ ) {
+				if( jobResults[job].has_value( ) && ( !result.has_value( ) || jobResults[job].value( ).size( ) < result.value( ).size( ) ) ) {
+					result = std::move( jobResults[job] );
+					resultEAs[functionIndex] = jobs[job].target.value( ).ea;
+				}
+			}
+		}
+		isDone[functionIndex] = true;
+		doneCount++;
+	};
+
+	for( size_t i = 0; i < functions.size( ); i++ ) {
+		pendingJobs[i] = firstJobs[i + 1] - firstJobs[i];
+		if( pendingJobs[i] == 0 ) {
+			finishFunction( i );
 		}
 	}
-}
 
-static void PrintSelectedCode( ea_t start, ea_t end, SignatureType sigType, bool wildcardOperands, uint32_t operandBitmask ) {
-	const auto selectionSize = end - start;
-	// Create signature of fixed size from selection
+	std::thread searchThread( [&] {
+		GetWorkerPool( ).ParallelFor( jobs.size( ), [&]( size_t i ) {
+			const auto& job = jobs[i];
+			if( job.target.has_value( ) ) {
+				jobResults[i] = FindUniqueSignaturePrefix( job.target.value( ), wildcardOperands, operandTypeBitmask, isCancelled );
+			}
+			else {
+				jobResults[i] = std::unexpected( job.target.error( ) );
+			}
+			if( --pendingJobs[job.functionIndex] == 0 ) {
+				finishFunction( job.functionIndex );
+			}
+		} );
+		isFinished = true;
+	} );
+
+	size_t writtenCount = 0;
+	size_t signatureCount = 0;
+	const auto writeFinishedResults = [&] {
+		for( ; writtenCount < results.size( ) && isDone[writtenCount]; writtenCount++ ) {
+			const auto& result = results[writtenCount];
+			const auto ea = functions[writtenCount]->start_ea;
+			const auto name = functionNames[writtenCount].c_str( );
+			if( !result.has_value( ) ) {
+				output << std::format( "{:X} {}: Error: {}\n", ea, name, result.error( ) );
+				continue;
+			}
 
-	auto signature = GenerateSignatureForEARange( start, end, wildcardOperands, operandBitmask );
-	if( !signature.has_value( ) ) {
-		msg( "Error: %s\n", signature.error( ).c_str( ) );
-		return;
+			if( resultEAs[writtenCount] != ea ) {
+				output << std::format( "{:X} {}: XREF @ {:X}: {}\n", ea, name, resultEAs[writtenCount], FormatSignature( result.value( ), sigType ) );
+			}
+			else {
+				output << std::format( "{:X} {}: {}\n", ea, name, FormatSignature( result.value( ), sigType ) );
+			}
+			signatureCount++;
+		}
+	};
+
+	while( !isFinished ) {
+		std::this_thread::sleep_for( std::chrono::milliseconds( 100 ) );
+		if( user_cancelled( ) ) {
+			isCancelled = true;
+		}
+		writeFinishedResults( );
+		replace_wait_box( "Generated %llu of %llu signatures...", doneCount.load( ), results.size( ) );
 	}
+	searchThread.join( );
+	writeFinishedResults( );
 
-	const auto signatureStr = FormatSignature( signature.value( ), sigType );
-	msg( "Code for %I64X-%I64X: %s\n", start, end, signatureStr.c_str( ) );
-	SetClipboardText( signatureStr );
+	const auto elapsedTime = std::chrono::duration_cast<std::chrono::milliseconds>( std::chrono::steady_clock::now( ) - startTime );
+	msg( "Created %llu unique signatures for %llu functions in %lld ms, saved to %s\n", signatureCount, functions.size( ), elapsedTime.count( ), outputPath.c_str( ) );
 }
 
-static void SearchSignatureString( std::string input ) {
+// Convert any supported signature format to an IDA style signature, empty if the format is not recognized
+static std::string ConvertSignatureString( std::string input ) {
 	// Try to figure out what signature type is used
 	// We will convert it to IDA style
 	std::string convertedSignatureString;
@@ -386,8 +1805,7 @@ static void SearchSignatureString( std::string input ) {
 		if( GetRegexMatches( input, std::regex( R"(\\x(?:[0-9A-F]{2}))" ), rawByteStrings ) && rawByteStrings.size( ) == stringMask.length( ) ) {
 			Signature convertedSignature;
 			for( size_t i = 0; const auto & m : rawByteStrings ) {
-				SignatureByte b{ std::stoi( m.substr( 2 ), nullptr, 16 ), stringMask[i++] == '?' };
-				convertedSignature.push_back( b );
+				convertedSignature.Append( static_cast<uint8_t>( std::stoi( m.substr( 2 ), nullptr, 16 ) ), stringMask[i++] == '?' );
 			}
 			convertedSignatureString = BuildIDASignatureString( convertedSignature );
 		}
@@ -395,8 +1813,7 @@ static void SearchSignatureString( std::string input ) {
 		else if( GetRegexMatches( input, std::regex( R"((?:0x(?:[0-9A-F]{2}))+)" ), rawByteStrings ) && rawByteStrings.size( ) == stringMask.length( ) ) {
 			Signature convertedSignature;
 			for( size_t i = 0; const auto & m : rawByteStrings ) {
-				SignatureByte b{ std::stoi( m.substr( 2 ), nullptr, 16 ), stringMask[i++] == '?' };
-				convertedSignature.push_back( b );
+				convertedSignature.Append( static_cast<uint8_t>( std::stoi( m.substr( 2 ), nullptr, 16 ) ), stringMask[i++] == '?' );
 			}
 			convertedSignatureString = BuildIDASignatureString( convertedSignature );
 		}
@@ -432,8 +1849,7 @@ static void SearchSignatureString( std::string input ) {
 			if( GetRegexMatches( input, std::regex( R"(\\x(?:[0-9A-F]{2}))" ), rawByteStrings ) && rawByteStrings.size( ) > 1 ) {
 				Signature convertedSignature;
 				for( size_t i = 0; const auto & m : rawByteStrings ) {
-					SignatureByte b{ std::stoi( m.substr( 2 ), nullptr, 16 ), false };
-					convertedSignature.push_back( b );
+					convertedSignature.Append( static_cast<uint8_t>( std::stoi( m.substr( 2 ), nullptr, 16 ) ), false );
 				}
 				convertedSignatureString = BuildIDASignatureString( convertedSignature );
 			}
@@ -441,8 +1857,7 @@ static void SearchSignatureString( std::string input ) {
 			else if( GetRegexMatches( input, std::regex( R"((?:0x(?:[0-9A-F]{2}))+)" ), rawByteStrings ) && rawByteStrings.size( ) > 1 ) {
 				Signature convertedSignature;
 				for( size_t i = 0; const auto & m : rawByteStrings ) {
-					SignatureByte b{ std::stoi( m.substr( 2 ), nullptr, 16 ), false };
-					convertedSignature.push_back( b );
+					convertedSignature.Append( static_cast<uint8_t>( std::stoi( m.substr( 2 ), nullptr, 16 ) ), false );
 				}
 				convertedSignatureString = BuildIDASignatureString( convertedSignature );
 			}
@@ -454,14 +1869,67 @@ static void SearchSignatureString( std::string input ) {
 
 	if( convertedSignatureString.empty( ) ) {
 		msg( "Unrecognized signature type\n" );
+	}
+	return convertedSignatureString;
+}
+
+// Offer a search that tolerates differing bytes, to find where a signature broken by an update moved to
+static void SearchApproximateSignature( const std::string& idaSignature ) {
+	// Default to about one mismatch per 8 defined bytes
+	size_t definedCount = 0;
+	std::istringstream tokens( idaSignature );
+	for( std::string token; tokens >> token; ) {
+		definedCount += token[0] != '?';
+	}
+	sval_t maxMismatches = std::max<sval_t>( 1, definedCount / 8 );
+	if( !ask_long( &maxMismatches, "Search for locations with up to this many differing bytes" ) || maxMismatches <= 0 ) {
+		return;
+	}
+	if( static_cast<size_t>( maxMismatches ) >= definedCount ) {
+		msg( "At least one byte of the signature has to match\n" );
+		return;
+	}
+
+	replace_wait_box( "Searching with up to %lld differing bytes...", static_cast<long long>( maxMismatches ) );
+	const auto startTime = std::chrono::steady_clock::now( );
+	const auto occurences = FindApproximateSignatureOccurences( idaSignature, static_cast<size_t>( maxMismatches ) );
+	const auto searchTime = std::chrono::duration_cast<std::chrono::milliseconds>( std::chrono::steady_clock::now( ) - startTime );
+	if( occurences.empty( ) ) {
+		msg( "No location with up to %lld differing bytes found in %lld ms\n", static_cast<long long>( maxMismatches ), searchTime.count( ) );
+		return;
+	}
+
+	msg( "Found %llu locations with up to %lld differing bytes in %lld ms\n", occurences.size( ), static_cast<long long>( maxMismatches ), searchTime.count( ) );
+	constexpr size_t maxPrinted = 20;
+	for( size_t i = 0; i < occurences.size( ) && i < maxPrinted; i++ ) {
+		msg( "Approximate match @ %I64X with %llu differing bytes\n", occurences[i].ea, occurences[i].mismatches );
+	}
+	if( occurences.size( ) > maxPrinted ) {
+		msg( "... and %llu more\n", occurences.size( ) - maxPrinted );
+	}
+}
+
+static void SearchSignatureString( std::string input ) {
+	const auto convertedSignatureString = ConvertSignatureString( std::move( input ) );
+	if( convertedSignatureString.empty( ) ) {
 		return;
 	}
 
 	// Print results
 	msg( "Signature: %s\n", convertedSignatureString.c_str( ) );
+	if( !PrepareImageSnapshot( ) ) {
+		// Nothing was searched, so an empty result says nothing about the signature
+		msg( "Search cancelled while creating the image snapshot\n" );
+		return;
+	}
 	auto signatureMatches = FindSignatureOccurences( convertedSignatureString );
 	if( signatureMatches.empty( ) ) {
 		msg( "Signature does not match!\n" );
+		if( user_cancelled( ) ) {
+			msg( "Search cancelled, skipping approximate search\n" );
+			return;
+		}
+		SearchApproximateSignature( convertedSignatureString );
 		return;
 	}
 	for( const auto& ea : signatureMatches ) {
@@ -469,6 +1937,60 @@ static void SearchSignatureString( std::string input ) {
 	}
 }
 
+// Time bin_search3 and every search engine on the same signature, and check that they agree
+static void BenchmarkSearchEngines( std::string input ) {
+	const auto signatureString = ConvertSignatureString( std::move( input ) );
+	if( signatureString.empty( ) || !PrepareImageSnapshot( ) ) {
+		return;
+	}
+
+	compiled_binpat_vec_t binaryPattern;
+	parse_binpat_str( &binaryPattern, inf_get_min_ea(), signatureString.c_str( ), 16 );
+	std::vector<CompiledPattern> patterns;
+	for( const auto& pattern : binaryPattern ) {
+		patterns.push_back( CompileBinaryPattern( pattern ) );
+	}
+	msg( "Benchmarking signature: %s\n", signatureString.c_str( ) );
+	for( const auto& pattern : patterns ) {
+		const auto plan = PlanSearch( pattern );
+		msg( "Planner picks %s%s for %llu bytes, estimated %.3f cycles/byte\n", GetSearchEngineName( plan.engine ), plan.useIndex ? " with index" : "", pattern.size( ), plan.estimatedCost );
+	}
+
+	// IDA's own search as reference, it has to run on this thread
+	replace_wait_box( "Benchmarking bin_search3..." );
+	auto startTime = std::chrono::steady_clock::now( );
+	std::vector<ea_t> referenceResults;
+	for( auto ea = inf_get_min_ea(); ; ) {
+		const auto occurence = bin_search3( ea, inf_get_max_ea(), binaryPattern, BIN_SEARCH_FORWARD | BIN_SEARCH_NOSHOW );
+		if( occurence == BADADDR ) {
+			break;
+		}
+		referenceResults.push_back( occurence );
+		ea = occurence + 1;
+	}
+	auto searchTime = std::chrono::duration_cast<std::chrono::microseconds>( std::chrono::steady_clock::now( ) - startTime );
+	msg( "%-12s %6llu matches in %8.2f ms\n", "bin_search3", referenceResults.size( ), searchTime.count( ) / 1000.0 );
+
+	for( const auto engine : { SearchEngine::Anchor, SearchEngine::Horspool, SearchEngine::ShiftOr } ) {
+		if( !std::ranges::all_of( patterns, [&]( const CompiledPattern& pattern ) { return CanUseSearchEngine( engine, pattern ); } ) ) {
+			msg( "%-12s not usable for this signature\n", GetSearchEngineName( engine ) );
+			continue;
+		}
+
+		replace_wait_box( "Benchmarking %s...", GetSearchEngineName( engine ) );
+		startTime = std::chrono::steady_clock::now( );
+		std::vector<ea_t> results;
+		for( const auto& pattern : patterns ) {
+			ScanSnapshotRegions( pattern, engine, false, results, SIZE_MAX );
+		}
+		std::ranges::sort( results );
+		const auto [first, last] = std::ranges::unique( results );
+		results.erase( first, last );
+		searchTime = std::chrono::duration_cast<std::chrono::microseconds>( std::chrono::steady_clock::now( ) - startTime );
+		msg( "%-12s %6llu matches in %8.2f ms%s\n", GetSearchEngineName( engine ), results.size( ), searchTime.count( ) / 1000.0, results == referenceResults ? "" : ", differs from bin_search3" );
+	}
+}
+
 static uint32_t WildcardableOperandTypeBitmask = BIT( o_reg ) | BIT( o_mem ) | BIT( o_phrase ) | BIT( o_displ ) | BIT( o_imm ) | BIT( o_far ) | BIT( o_near ) | BIT( o_idpspec0 ) | BIT( o_idpspec1 ) | BIT( o_idpspec2 ) | BIT( o_idpspec3 ) | BIT( o_idpspec4 ) | BIT( o_idpspec5 );
 
 void ConfigureOperandWildcardBitmask( ) {
@@ -491,6 +2013,69 @@ void ConfigureOperandWildcardBitmask( ) {
 	}
 }
 
+void ConfigureSearchEngine( ) {
+	const char format[] =
+		"STARTITEM 0\n"															// TabStop
+		"Search Engine\n"															// Title
+		"Select the algorithm used to search for signatures:\n"					// Header
+		"<#Pick the engine per pattern#Automatic:R>\n"							// Radio Button 0
+		"<#Scan for the two rarest bytes with SIMD, then verify#Anchor scan:R>\n"	// Radio Button 1
+		"<#Skip through the image by the longest run of defined bytes#Horspool:R>\n"	// Radio Button 2
+		"<#Bit-parallel automaton, signatures up to 64 bytes#Shift-Or:R>>\n";		// Radio Button 3
+
+	// Engines that can't handle a pattern fall back to the automatic choice
+	short engine = static_cast<short>( PreferredSearchEngine );
+	if( ask_form( format, &engine ) ) {
+		PreferredSearchEngine = static_cast<SearchEngine>( engine );
+	}
+}
+
+plugin_ctx_t::~plugin_ctx_t( ) {
+	unhook_event_listener( HT_IDB, this );
+
+	// Free everything here, joining the worker threads while the DLL unloads could deadlock
+	InvalidateCaches( );
+	WorkerPool.reset( );
+}
+
+ssize_t idaapi plugin_ctx_t::on_event( ssize_t code, va_list ) {
+	switch( code ) {
+	case idb_event::byte_patched:
+	case idb_event::segm_added:
+	case idb_event::segm_deleted:
+	case idb_event::segm_start_changed:
+	case idb_event::segm_end_changed:
+	case idb_event::segm_moved:
+	case idb_event::allsegs_moved:
+	case idb_event::closebase:
+		InvalidateCaches( );
+		break;
+	// Instruction boundaries or decoding changed
+	case idb_event::make_code:
+	case idb_event::make_data:
+	case idb_event::destroyed_items:
+	case idb_event::sgr_changed:
+		WildcardMask.Clear( );
+		DecodedInstructions.Clear( );
+		FunctionHashes.Clear( );
+		CodeStream.Clear( );
+		break;
+	// Function bounds changed
+	case idb_event::func_added:
+	case idb_event::deleting_func:
+	case idb_event::func_updated:
+	case idb_event::set_func_start:
+	case idb_event::set_func_end:
+	case idb_event::func_tail_appended:
+	case idb_event::func_tail_deleted:
+		FunctionHashes.Clear( );
+		break;
+	default:
+		break;
+	}
+	return 0;
+}
+
 bool idaapi plugin_ctx_t::run( size_t ) {
 
 	// Check what processor we have
@@ -506,7 +2091,11 @@ bool idaapi plugin_ctx_t::run( size_t ) {
 		"<#Select an address, and create a code signature for it#Create unique Signature for current code address:R>\n"												// Radio Button 0
 		"<#Select an address or variable, and create code signatures for its references. Will output the shortest 5 signatures#Find shortest XREF Signature for current data or code address:R>\n"			// Radio Button 1
 		"<#Select 1+ instructions, and copy the bytes using the specified output format#Copy selected code:R>\n"													// Radio Button 2
-		"<#Paste any string containing your signature/mask and find matches#Search for a signature:R>>\n"															// Radio Button 3
+		"<#Paste any string containing your signature/mask and find matches#Search for a signature:R>\n"															// Radio Button 3
+		"<#Create signatures for all functions matching a name or segment filter, and save them to a file#Create signatures for all functions:R>\n"				// Radio Button 4
+		"<#Search every instruction of the current function for the shortest unique signature, and print its offset to the current address#Find shortest signature in current function:R>\n"	// Radio Button 5
+		"<#Select an address, and create a signature that can also start before it, printed with its offset to the address#Create unique Signature growing in both directions:R>\n"	// Radio Button 6
+		"<#Paste a signature and compare the search time of bin_search3 and all search engines#Benchmark search engines:R>>\n"									// Radio Button 7
 
 		"Output format:\n"																																			// Title
 		"<#Example - E8 ? ? ? ? 45 33 F6 66 44 89 34 33#IDA Signature:R>\n"																							// Radio Button 0
@@ -516,17 +2105,35 @@ bool idaapi plugin_ctx_t::run( size_t ) {
 
 		"Options:\n"																																				// Title
 		"<#Enable wildcarding for operands, to improve stability of created signatures#Wildcards for operands:C>\n"													// Checkbox Button 0											
-		"<#Don't stop signature generation when reaching end of function#Continue when leaving function scope:C>>\n"												// Checkbox Button 1
-		"<#Configure operand types that should be wildcarded#Operand types...:B::::>\n";																			// Button 0
+		"<#Don't stop signature generation when reaching end of function#Continue when leaving function scope:C>\n"												// Checkbox Button 1
+		"<#Build a suffix array over the code once, to speed up repeated searches like XREF mode#Use search index:C>\n"										// Checkbox Button 2
+		"<#Index 4-byte grams instead of building a suffix array, needs about as much memory as the code#Use lightweight q-gram index:C>\n"					// Checkbox Button 3
+		"<#Print the search engines the planner picked with their timings after each action#Print search statistics:C>>\n"								// Checkbox Button 4
+		"<#Configure operand types that should be wildcarded#Operand types...:B::::>\n"																			// Button 0
+		"<#Select the algorithm used to search for signatures#Search engine...:B::::>\n";																		// Button 1
 
 	static short action = 0;
 	static short outputFormat = 0;
-	static short options = ( 1 << 0 | 0 << 1 );
+	static short options = ( 1 << 0 | 0 << 1 | 0 << 2 );
 
-	if( ask_form( format, &action, &outputFormat, &options, &ConfigureOperandWildcardBitmask ) ) {
+	if( ask_form( format, &action, &outputFormat, &options, &ConfigureOperandWildcardBitmask, &ConfigureSearchEngine ) ) {
 		const auto wildcardOperands = options & ( 1 << 0 );
 		const auto continueOutsideOfFunction = options & ( 1 << 1 );
 
+		UseSearchIndex = options & ( 1 << 2 );
+		// Stay with the q-gram index after the suffix array failed to build
+		const bool useQGramIndex = ( options & ( 1 << 3 ) ) || HasSuffixIndexFailed;
+		if( !UseSearchIndex || useQGramIndex != UseQGramIndex ) {
+			// Free the index memory, or rebuild with the other index type. The function hashes don't depend on the index
+			CodeStream.Clear( );
+			CodeIndex.Clear( );
+			CodeQGrams.Clear( );
+		}
+		UseQGramIndex = useQGramIndex;
+
+		const auto printSearchStatistics = options & ( 1 << 4 );
+		SearchAudit.Clear( );
+
 		const auto sigType = static_cast<SignatureType>( outputFormat );
 		switch( action ) {
 		case 0:
@@ -536,6 +2143,20 @@ bool idaapi plugin_ctx_t::run( size_t ) {
 
 			show_wait_box( "Generating signature..." );
 
+			// Signatures that stay inside the function can never be unique in a duplicated function
+			if( !continueOutsideOfFunction && PrepareFunctionHashes( wildcardOperands, WildcardableOperandTypeBitmask ) ) {
+				if( const auto identicalFunctions = FindIdenticalFunctions( ea, wildcardOperands, continueOutsideOfFunction, WildcardableOperandTypeBitmask ); !identicalFunctions.empty( ) ) {
+					msg( "%s, creating XREF signatures instead\n", FormatIdenticalFunctions( identicalFunctions ).c_str( ) );
+
+					std::vector<std::tuple<ea_t, Signature>> xrefSignatures;
+					const auto xrefCount = FindXRefs( ea, wildcardOperands, continueOutsideOfFunction, xrefSignatures, 250, WildcardableOperandTypeBitmask, 5 );
+					PrintXRefSignaturesForEA( ea, xrefSignatures, xrefCount, sigType, 5 );
+
+					hide_wait_box( );
+					break;
+				}
+			}
+
 			auto signature = GenerateUniqueSignatureForEA( ea, wildcardOperands, continueOutsideOfFunction, WildcardableOperandTypeBitmask );
 			PrintSignatureForEA( signature, ea, sigType );
 
@@ -550,10 +2171,10 @@ bool idaapi plugin_ctx_t::run( size_t ) {
 
 			show_wait_box( "Finding references and generating signatures. This can take a while..." );
 
-			FindXRefs( ea, wildcardOperands, continueOutsideOfFunction, xrefSignatures, 250, WildcardableOperandTypeBitmask );
+			const auto xrefCount = FindXRefs( ea, wildcardOperands, continueOutsideOfFunction, xrefSignatures, 250, WildcardableOperandTypeBitmask, 5 );
 
 			// Print top 5 shortest signatures
-			PrintXRefSignaturesForEA( ea, xrefSignatures, sigType, 5 );
+			PrintXRefSignaturesForEA( ea, xrefSignatures, xrefCount, sigType, 5 );
 
 			hide_wait_box( );
 			break;
@@ -587,9 +2208,79 @@ bool idaapi plugin_ctx_t::run( size_t ) {
 			}
 			break;
 		}
+		case 4:
+		{
+			// Create signatures for all functions
+			const char filterFormat[] =
+				"STARTITEM 0\n"
+				"Create signatures for all functions\n"
+				"<#Regular expression the function name has to contain, leave empty for all functions#Name filter:q:0:60::>\n"
+				"<#Name of the segment the functions have to be in, leave empty for all segments#Segment:q:0:20::>\n";
+
+			qstring nameFilter, segmentFilter;
+			if( !ask_form( filterFormat, &nameFilter, &segmentFilter ) ) {
+				break;
+			}
+
+			const auto outputFile = ask_file( true, "*.txt", "Save signatures to" );
+			if( outputFile == nullptr ) {
+				break;
+			}
+			const std::string outputPath = outputFile;
+
+			show_wait_box( "Generating signatures for all functions..." );
+
+			GenerateSignaturesForFunctions( nameFilter.c_str( ), segmentFilter.c_str( ), outputPath, sigType, wildcardOperands, continueOutsideOfFunction, WildcardableOperandTypeBitmask );
+
+			hide_wait_box( );
+			break;
+		}
+		case 5:
+		{
+			// Find shortest signature anywhere in the current function
+			const auto ea = get_screen_ea( );
+
+			show_wait_box( "Searching function for the shortest signature..." );
+
+			const auto signature = FindShortestSignatureInFunction( ea, wildcardOperands, continueOutsideOfFunction, WildcardableOperandTypeBitmask, 1000 );
+			PrintOffsetSignatureForEA( signature, ea, sigType );
+
+			hide_wait_box( );
+			break;
+		}
+		case 6:
+		{
+			// Find unique signature around current address
+			const auto ea = get_screen_ea( );
+
+			show_wait_box( "Generating signature..." );
+
+			const auto signature = GenerateBidirectionalSignatureForEA( ea, wildcardOperands, continueOutsideOfFunction, WildcardableOperandTypeBitmask, 1000 );
+			PrintOffsetSignatureForEA( signature, ea, sigType );
+
+			hide_wait_box( );
+			break;
+		}
+		case 7:
+		{
+			// Compare the search engines on a signature
+			qstring inputSignatureQstring;
+			if( ask_str( &inputSignatureQstring, HIST_SRCH, "Enter a signature to benchmark" ) ) {
+				show_wait_box( "Benchmarking..." );
+
+				BenchmarkSearchEngines( inputSignatureQstring.c_str( ) );
+
+				hide_wait_box( );
+			}
+			break;
+		}
 		default:
 			break;
 		}
+
+		if( printSearchStatistics ) {
+			PrintSearchAudit( );
+		}
 	}
 	return true;
 }
@@ -6,10 +6,24 @@
 #include <sstream>
 #include <format>
 #include <vector>
+#include <chrono>
+#include <span>
+#include <fstream>
+#include <optional>
 
 
 #include "Version.h"
 #include "Plugin.h"
+#include "ImageSnapshot.h"
+#include "PatternMatcher.h"
+#include "SearchPlanner.h"
+#include "SuffixIndex.h"
+#include "QGramIndex.h"
+#include "NormalizedCodeStream.h"
+#include "FunctionHashTable.h"
+#include "InstructionCache.h"
+#include "WildcardBitmap.h"
+#include "Signature.h"
 
 // Signature types and structures
 enum class SignatureType : uint32_t {
@@ -19,9 +33,3 @@ enum class SignatureType : uint32_t {
 	SignatureByteArray_Bitmask
 };
 
-typedef struct {
-	uint8_t value;
-	bool isWildcard;
-} SignatureByte;
-
-using Signature = std::vector<SignatureByte>;
\ No newline at end of file
@@ -0,0 +1,79 @@
+#include "NormalizedCodeStream.h"
+#include <algorithm>
+
+void NormalizedCodeStream::Clear( ) {
+	isBuilt = false;
+	stream = {};
+	runs = {};
+	index.Clear( );
+	qgramIndex.Clear( );
+}
+
+void NormalizedCodeStream::BeginBuild( uint32_t bitmask ) {
+	Clear( );
+	operandTypeBitmask = bitmask;
+}
+
+void NormalizedCodeStream::AddInstruction( ea_t ea, const uint8_t* bytes, size_t size, size_t operandOffset, size_t operandLength ) {
+	if( runs.empty( ) || runs.back( ).startEA + runs.back( ).size != ea ) {
+		runs.push_back( { ea, stream.size( ), 0 } );
+	}
+	runs.back( ).size += size;
+
+	const auto start = stream.size( );
+	stream.insert( stream.end( ), bytes, bytes + size );
+	if( operandLength > 0 ) {
+		const auto end = std::min( operandOffset + operandLength, size );
+		std::fill( stream.begin( ) + start + operandOffset, stream.begin( ) + start + end, 0 );
+	}
+}
+
+void NormalizedCodeStream::FinishBuild( bool buildIndex, bool useQGramIndex ) {
+	stream.shrink_to_fit( );
+	runs.shrink_to_fit( );
+
+	if( buildIndex && useQGramIndex ) {
+		std::vector<QGramIndex::TextRun> textRuns;
+		for( const auto& run : runs ) {
+			textRuns.push_back( { run.startEA, stream.data( ) + run.offset, run.size } );
+		}
+		qgramIndex.Build( textRuns );
+	}
+	else if( buildIndex ) {
+		std::vector<SuffixIndex::TextRun> textRuns;
+		for( const auto& run : runs ) {
+			textRuns.push_back( { run.startEA, stream.data( ) + run.offset, run.size } );
+		}
+		index.Build( textRuns );
+	}
+	isBuilt = true;
+}
+
+size_t NormalizedCodeStream::GetMemoryUsage( ) const {
+	return stream.capacity( ) + runs.capacity( ) * sizeof( Run ) + index.GetMemoryUsage( ) + qgramIndex.GetMemoryUsage( );
+}
+
+void NormalizedCodeStream::Find( const uint8_t* bytes, size_t length, std::vector<ea_t>& results, size_t maxResults ) const {
+	CompiledPattern pattern;
+	for( size_t i = 0; i < length; i++ ) {
+		AppendPatternByte( pattern, bytes[i], 0xFF );
+	}
+	SelectPatternAnchors( pattern );
+
+	if( index.Find( pattern, results, maxResults ) || qgramIndex.Find( pattern, results, maxResults ) ) {
+		return;
+	}
+
+	// No index, scan the stream
+	std::vector<size_t> offsets;
+	for( const auto& run : runs ) {
+		offsets.clear( );
+		FindPattern( pattern, stream.data( ) + run.offset, run.size, offsets, maxResults - results.size( ) );
+		for( const auto offset : offsets ) {
+			results.push_back( run.startEA + offset );
+		}
+		if( results.size( ) >= maxResults ) {
+			return;
+		}
+	}
+}
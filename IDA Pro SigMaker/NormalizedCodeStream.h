@@ -0,0 +1,50 @@
+#pragma once
+#include <vector>
+#include <cstdint>
+
+#include "Plugin.h"
+#include "PatternMatcher.h"
+#include "SuffixIndex.h"
+#include "QGramIndex.h"
+
+// All instructions of the code segments with their wildcardable operand bytes zeroed
+// A wildcarded signature with its wildcards set to zero is an exact substring of this stream
+class NormalizedCodeStream {
+public:
+	void Clear( );
+	bool IsBuilt( ) const {
+		return isBuilt;
+	}
+	uint32_t GetOperandTypeBitmask( ) const {
+		return operandTypeBitmask;
+	}
+
+	// Instructions have to be added in ascending address order
+	void BeginBuild( uint32_t operandTypeBitmask );
+	void AddInstruction( ea_t ea, const uint8_t* bytes, size_t size, size_t operandOffset, size_t operandLength );
+	// The q-gram index needs a fraction of the suffix array's memory
+	void FinishBuild( bool buildIndex, bool useQGramIndex = false );
+
+	// Exact search for the normalized bytes, returns the addresses of the matching instructions
+	void Find( const uint8_t* bytes, size_t length, std::vector<ea_t>& results, size_t maxResults ) const;
+
+	size_t GetSize( ) const {
+		return stream.size( );
+	}
+	size_t GetMemoryUsage( ) const;
+
+private:
+	// Contiguous instructions, bytes map linearly to addresses
+	struct Run {
+		ea_t startEA;
+		size_t offset;
+		size_t size;
+	};
+
+	bool isBuilt = false;
+	uint32_t operandTypeBitmask = 0;
+	std::vector<uint8_t> stream;
+	std::vector<Run> runs;
+	SuffixIndex index;
+	QGramIndex qgramIndex;
+};
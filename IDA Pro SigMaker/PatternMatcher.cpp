@@ -0,0 +1,584 @@
+#include "PatternMatcher.h"
+#include <intrin.h>
+#include <immintrin.h>
+#include <bit>
+#include <cstring>
+#include <algorithm>
+#include <atomic>
+#include <limits>
+
+namespace {
+	std::atomic<const ByteHistogram*> AnchorHistogram = nullptr;
+
+	using SearchKernel = void( * )( const CompiledPattern& pattern, const uint8_t* data, size_t size, std::vector<size_t>& results, size_t maxResults );
+
+	// Verify every position, only used for patterns without fully defined bytes
+	void SearchBruteForce( const CompiledPattern& pattern, const uint8_t* data, size_t size, std::vector<size_t>& results, size_t maxResults ) {
+		for( size_t i = 0; i + pattern.size( ) <= size; i++ ) {
+			if( IsPatternMatch( pattern, data + i ) ) {
+				results.push_back( i );
+				if( results.size( ) >= maxResults ) {
+					return;
+				}
+			}
+		}
+	}
+
+	// Verify the candidates in a movemask result, returns false once maxResults is reached
+	template<typename MaskType>
+	bool VerifyCandidates( const CompiledPattern& pattern, const uint8_t* data, size_t position, MaskType candidates, std::vector<size_t>& results, size_t maxResults ) {
+		while( candidates != 0 ) {
+			const auto match = position + std::countr_zero( candidates );
+			candidates &= candidates - 1;
+			if( IsPatternMatch( pattern, data + match ) ) {
+				results.push_back( match );
+				if( results.size( ) >= maxResults ) {
+					return false;
+				}
+			}
+		}
+		return true;
+	}
+
+	// Check the positions the vectorized loop did not cover
+	void SearchTail( const CompiledPattern& pattern, const uint8_t* data, size_t position, size_t positionCount, std::vector<size_t>& results, size_t maxResults ) {
+		for( ; position < positionCount; position++ ) {
+			if( data[position + pattern.anchorOffset] != pattern.bytes[pattern.anchorOffset] ) {
+				continue;
+			}
+			if( IsPatternMatch( pattern, data + position ) ) {
+				results.push_back( position );
+				if( results.size( ) >= maxResults ) {
+					return;
+				}
+			}
+		}
+	}
+
+	void SearchScalar( const CompiledPattern& pattern, const uint8_t* data, size_t size, std::vector<size_t>& results, size_t maxResults ) {
+		const auto positionCount = size - pattern.size( ) + 1;
+		const auto anchor = pattern.bytes[pattern.anchorOffset];
+
+		// memchr is vectorized by the CRT already
+		auto position = static_cast<size_t>( 0 );
+		while( position < positionCount ) {
+			const auto found = static_cast<const uint8_t*>( memchr( data + position + pattern.anchorOffset, anchor, positionCount - position ) );
+			if( found == nullptr ) {
+				return;
+			}
+			position = static_cast<size_t>( found - data ) - pattern.anchorOffset;
+			if( IsPatternMatch( pattern, data + position ) ) {
+				results.push_back( position );
+				if( results.size( ) >= maxResults ) {
+					return;
+				}
+			}
+			position++;
+		}
+	}
+
+	void SearchSSE2( const CompiledPattern& pattern, const uint8_t* data, size_t size, std::vector<size_t>& results, size_t maxResults ) {
+		const auto positionCount = size - pattern.size( ) + 1;
+		const auto secondOffset = pattern.hasSecondAnchor ? pattern.secondAnchorOffset : pattern.anchorOffset;
+		const auto firstAnchor = _mm_set1_epi8( static_cast<char>( pattern.bytes[pattern.anchorOffset] ) );
+		const auto secondAnchor = _mm_set1_epi8( static_cast<char>( pattern.bytes[secondOffset] ) );
+
+		size_t position = 0;
+		for( ; position + 16 <= positionCount; position += 16 ) {
+			const auto first = _mm_cmpeq_epi8( _mm_loadu_si128( reinterpret_cast<const __m128i*>( data + position + pattern.anchorOffset ) ), firstAnchor );
+			const auto second = _mm_cmpeq_epi8( _mm_loadu_si128( reinterpret_cast<const __m128i*>( data + position + secondOffset ) ), secondAnchor );
+			const auto candidates = static_cast<uint32_t>( _mm_movemask_epi8( _mm_and_si128( first, second ) ) );
+			if( !VerifyCandidates( pattern, data, position, candidates, results, maxResults ) ) {
+				return;
+			}
+		}
+		SearchTail( pattern, data, position, positionCount, results, maxResults );
+	}
+
+	void SearchAVX2( const CompiledPattern& pattern, const uint8_t* data, size_t size, std::vector<size_t>& results, size_t maxResults ) {
+		const auto positionCount = size - pattern.size( ) + 1;
+		const auto secondOffset = pattern.hasSecondAnchor ? pattern.secondAnchorOffset : pattern.anchorOffset;
+		const auto firstAnchor = _mm256_set1_epi8( static_cast<char>( pattern.bytes[pattern.anchorOffset] ) );
+		const auto secondAnchor = _mm256_set1_epi8( static_cast<char>( pattern.bytes[secondOffset] ) );
+
+		size_t position = 0;
+		for( ; position + 32 <= positionCount; position += 32 ) {
+			const auto first = _mm256_cmpeq_epi8( _mm256_loadu_si256( reinterpret_cast<const __m256i*>( data + position + pattern.anchorOffset ) ), firstAnchor );
+			const auto second = _mm256_cmpeq_epi8( _mm256_loadu_si256( reinterpret_cast<const __m256i*>( data + position + secondOffset ) ), secondAnchor );
+			const auto candidates = static_cast<uint32_t>( _mm256_movemask_epi8( _mm256_and_si256( first, second ) ) );
+			if( !VerifyCandidates( pattern, data, position, candidates, results, maxResults ) ) {
+				_mm256_zeroupper( );
+				return;
+			}
+		}
+		_mm256_zeroupper( );
+		SearchTail( pattern, data, position, positionCount, results, maxResults );
+	}
+
+	void SearchAVX512( const CompiledPattern& pattern, const uint8_t* data, size_t size, std::vector<size_t>& results, size_t maxResults ) {
+		const auto positionCount = size - pattern.size( ) + 1;
+		const auto secondOffset = pattern.hasSecondAnchor ? pattern.secondAnchorOffset : pattern.anchorOffset;
+		const auto firstAnchor = _mm512_set1_epi8( static_cast<char>( pattern.bytes[pattern.anchorOffset] ) );
+		const auto secondAnchor = _mm512_set1_epi8( static_cast<char>( pattern.bytes[secondOffset] ) );
+
+		size_t position = 0;
+		for( ; position + 64 <= positionCount; position += 64 ) {
+			const auto first = _mm512_cmpeq_epi8_mask( _mm512_loadu_si512( data + position + pattern.anchorOffset ), firstAnchor );
+			const auto candidates = _mm512_mask_cmpeq_epi8_mask( first, _mm512_loadu_si512( data + position + secondOffset ), secondAnchor );
+			if( !VerifyCandidates( pattern, data, position, static_cast<uint64_t>( candidates ), results, maxResults ) ) {
+				_mm256_zeroupper( );
+				return;
+			}
+		}
+		_mm256_zeroupper( );
+		SearchTail( pattern, data, position, positionCount, results, maxResults );
+	}
+
+	MatcherLevel DetectMatcherLevel( ) {
+		int info[4]{};
+		__cpuid( info, 0 );
+		const auto maxLeaf = info[0];
+
+		__cpuid( info, 1 );
+		const bool hasSSE2 = ( info[3] & ( 1 << 26 ) ) != 0;
+		const bool hasOSXSAVE = ( info[2] & ( 1 << 27 ) ) != 0;
+		const bool hasAVX = ( info[2] & ( 1 << 28 ) ) != 0;
+		if( !hasSSE2 ) {
+			return MatcherLevel::Scalar;
+		}
+		if( maxLeaf < 7 || !hasOSXSAVE || !hasAVX ) {
+			return MatcherLevel::SSE2;
+		}
+
+		// Check that the OS saves the YMM and ZMM registers
+		const auto xcr0 = _xgetbv( 0 );
+		const bool osSupportsAVX = ( xcr0 & 0x6 ) == 0x6;
+		const bool osSupportsAVX512 = ( xcr0 & 0xE6 ) == 0xE6;
+
+		__cpuidex( info, 7, 0 );
+		const bool hasAVX2 = ( info[1] & ( 1 << 5 ) ) != 0;
+		const bool hasAVX512F = ( info[1] & ( 1 << 16 ) ) != 0;
+		const bool hasAVX512BW = ( info[1] & ( 1 << 30 ) ) != 0;
+
+		if( osSupportsAVX512 && hasAVX512F && hasAVX512BW ) {
+			return MatcherLevel::AVX512;
+		}
+		if( osSupportsAVX && hasAVX2 ) {
+			return MatcherLevel::AVX2;
+		}
+		return MatcherLevel::SSE2;
+	}
+
+	SearchKernel GetSearchKernel( MatcherLevel level ) {
+		switch( level ) {
+		case MatcherLevel::AVX512:
+			return SearchAVX512;
+		case MatcherLevel::AVX2:
+			return SearchAVX2;
+		case MatcherLevel::SSE2:
+			return SearchSSE2;
+		default:
+			return SearchScalar;
+		}
+	}
+}
+
+MatcherLevel GetMatcherLevel( ) {
+	static const auto level = DetectMatcherLevel( );
+	return level;
+}
+
+const char* GetMatcherLevelName( MatcherLevel level ) {
+	switch( level ) {
+	case MatcherLevel::AVX512:
+		return "AVX-512";
+	case MatcherLevel::AVX2:
+		return "AVX2";
+	case MatcherLevel::SSE2:
+		return "SSE2";
+	default:
+		return "Scalar";
+	}
+}
+
+void AppendPatternByte( CompiledPattern& pattern, uint8_t value, uint8_t mask ) {
+	pattern.bytes.push_back( value & mask );
+	pattern.mask.push_back( mask );
+	pattern.hasAnchor = false;
+	pattern.hasSecondAnchor = false;
+}
+
+void AddToByteHistogram( ByteHistogram& histogram, const uint8_t* data, size_t size ) {
+	for( size_t i = 0; i < size; i++ ) {
+		histogram.byteCounts[data[i]]++;
+	}
+	for( size_t i = 1; i < size; i++ ) {
+		histogram.pairCounts[data[i - 1] << 8 | data[i]]++;
+	}
+	histogram.size += size;
+}
+
+void MergeByteHistogram( ByteHistogram& histogram, const ByteHistogram& other ) {
+	for( size_t i = 0; i < histogram.byteCounts.size( ); i++ ) {
+		histogram.byteCounts[i] += other.byteCounts[i];
+	}
+	for( size_t i = 0; i < histogram.pairCounts.size( ); i++ ) {
+		histogram.pairCounts[i] += other.pairCounts[i];
+	}
+	histogram.size += other.size;
+}
+
+void SetAnchorHistogram( const ByteHistogram* histogram ) {
+	AnchorHistogram = histogram;
+}
+
+void SelectPatternAnchors( CompiledPattern& pattern ) {
+	pattern.hasAnchor = false;
+	pattern.hasSecondAnchor = false;
+
+	const auto histogram = AnchorHistogram.load( );
+	const auto getByteCount = [&]( size_t offset ) -> double {
+		return histogram ? static_cast<double>( histogram->byteCounts[pattern.bytes[offset]] ) : 1.0;
+	};
+
+	std::vector<size_t> concreteOffsets;
+	for( size_t i = 0; i < pattern.size( ); i++ ) {
+		if( pattern.mask[i] == 0xFF ) {
+			concreteOffsets.push_back( i );
+		}
+	}
+	if( concreteOffsets.empty( ) ) {
+		return;
+	}
+
+	// Rarest single byte first, the scalar kernel only scans for this one
+	std::ranges::stable_sort( concreteOffsets, [&]( size_t a, size_t b ) { return getByteCount( a ) < getByteCount( b ); } );
+	pattern.anchorOffset = concreteOffsets.front( );
+	pattern.hasAnchor = true;
+	if( concreteOffsets.size( ) == 1 ) {
+		return;
+	}
+
+	// Expected hits of a pair: exact for adjacent bytes, otherwise assume the bytes are independent.
+	// Pairs are taken among the rarest bytes, plus every adjacent pair
+	const auto getPairCount = [&]( size_t first, size_t second ) -> double {
+		if( histogram == nullptr ) {
+			return 1.0;
+		}
+		if( second == first + 1 ) {
+			return static_cast<double>( histogram->pairCounts[pattern.bytes[first] << 8 | pattern.bytes[second]] );
+		}
+		return getByteCount( first ) * getByteCount( second ) / std::max<double>( static_cast<double>( histogram->size ), 1.0 );
+	};
+
+	double bestCount = std::numeric_limits<double>::max( );
+	const auto considerPair = [&]( size_t first, size_t second ) {
+		const auto count = getPairCount( std::min( first, second ), std::max( first, second ) );
+		if( count < bestCount ) {
+			bestCount = count;
+			pattern.anchorOffset = getByteCount( first ) <= getByteCount( second ) ? first : second;
+			pattern.secondAnchorOffset = pattern.anchorOffset == first ? second : first;
+			pattern.hasSecondAnchor = true;
+		}
+	};
+
+	constexpr size_t maxPairCandidates = 16;
+	const auto candidateCount = std::min( concreteOffsets.size( ), maxPairCandidates );
+	for( size_t i = 0; i < candidateCount; i++ ) {
+		for( size_t j = i + 1; j < candidateCount; j++ ) {
+			considerPair( concreteOffsets[i], concreteOffsets[j] );
+		}
+	}
+	for( size_t i = 0; i + 1 < pattern.size( ); i++ ) {
+		if( pattern.mask[i] == 0xFF && pattern.mask[i + 1] == 0xFF ) {
+			considerPair( i, i + 1 );
+		}
+	}
+}
+
+bool IsPatternMatch( const CompiledPattern& pattern, const uint8_t* data ) {
+	const auto length = pattern.size( );
+	const auto bytes = pattern.bytes.data( );
+	const auto mask = pattern.mask.data( );
+
+	// Masked compare 8 bytes at a time
+	size_t i = 0;
+	for( ; i + 8 <= length; i += 8 ) {
+		uint64_t value, expected, compareMask;
+		memcpy( &value, data + i, 8 );
+		memcpy( &expected, bytes + i, 8 );
+		memcpy( &compareMask, mask + i, 8 );
+		if( ( value & compareMask ) != expected ) {
+			return false;
+		}
+	}
+	for( ; i < length; i++ ) {
+		if( ( data[i] & mask[i] ) != bytes[i] ) {
+			return false;
+		}
+	}
+	return true;
+}
+
+void FindPattern( const CompiledPattern& pattern, const uint8_t* data, size_t size, std::vector<size_t>& results, size_t maxResults ) {
+	if( pattern.size( ) == 0 || size < pattern.size( ) || results.size( ) >= maxResults ) {
+		return;
+	}
+
+	if( !pattern.hasAnchor ) {
+		SearchBruteForce( pattern, data, size, results, maxResults );
+		return;
+	}
+
+	static const auto kernel = GetSearchKernel( GetMatcherLevel( ) );
+	kernel( pattern, data, size, results, maxResults );
+}
+
+ConcreteRun FindLongestConcreteRun( const CompiledPattern& pattern ) {
+	ConcreteRun longestRun;
+	for( size_t i = 0; i < pattern.size( ); ) {
+		if( pattern.mask[i] != 0xFF ) {
+			i++;
+			continue;
+		}
+		auto end = i;
+		while( end < pattern.size( ) && pattern.mask[end] == 0xFF ) {
+			end++;
+		}
+		if( end - i >= longestRun.length ) {
+			longestRun = { i, end - i };
+		}
+		i = end;
+	}
+	return longestRun;
+}
+
+void FindPatternHorspool( const CompiledPattern& pattern, const uint8_t* data, size_t size, std::vector<size_t>& results, size_t maxResults ) {
+	if( pattern.size( ) == 0 || size < pattern.size( ) || results.size( ) >= maxResults ) {
+		return;
+	}
+
+	// Wildcards would limit every shift to their distance from the end, so only the concrete run is searched for
+	const auto run = FindLongestConcreteRun( pattern );
+	if( run.length < 2 ) {
+		FindPattern( pattern, data, size, results, maxResults );
+		return;
+	}
+	const auto runBytes = pattern.bytes.data( ) + run.offset;
+	const auto runLast = runBytes[run.length - 1];
+
+	size_t shifts[256];
+	std::fill( std::begin( shifts ), std::end( shifts ), run.length );
+	for( size_t i = 0; i + 1 < run.length; i++ ) {
+		shifts[runBytes[i]] = run.length - 1 - i;
+	}
+
+	// Run positions whose pattern still fits into the data
+	const auto lastPosition = size - pattern.size( ) + run.offset;
+	for( auto position = run.offset; position <= lastPosition; ) {
+		const auto last = data[position + run.length - 1];
+		if( last == runLast && memcmp( data + position, runBytes, run.length - 1 ) == 0 ) {
+			const auto start = position - run.offset;
+			if( IsPatternMatch( pattern, data + start ) ) {
+				results.push_back( start );
+				if( results.size( ) >= maxResults ) {
+					return;
+				}
+			}
+		}
+		position += shifts[last];
+	}
+}
+
+namespace {
+	// Bit i of the mask for a byte is clear if the byte matches pattern position i
+	void BuildShiftOrMasks( const CompiledPattern& pattern, uint64_t* masks ) {
+		for( size_t value = 0; value < 256; value++ ) {
+			auto mask = ~0ull;
+			for( size_t i = 0; i < pattern.size( ); i++ ) {
+				if( ( value & pattern.mask[i] ) == pattern.bytes[i] ) {
+					mask &= ~( 1ull << i );
+				}
+			}
+			masks[value] = mask;
+		}
+	}
+
+	// Report matches starting in [start, end), reads up to end + pattern.size( ) - 1
+	bool SearchShiftOrScalar( const uint64_t* masks, size_t patternSize, const uint8_t* data, size_t start, size_t end, std::vector<size_t>& results, size_t maxResults ) {
+		const auto matchBit = 1ull << ( patternSize - 1 );
+		auto state = ~0ull;
+		for( auto position = start; position < end + patternSize - 1; position++ ) {
+			state = ( state << 1 ) | masks[data[position]];
+			if( ( state & matchBit ) == 0 ) {
+				results.push_back( position + 1 - patternSize );
+				if( results.size( ) >= maxResults ) {
+					return false;
+				}
+			}
+		}
+		return true;
+	}
+
+	// One automaton per 64-bit lane, each lane owns a quarter of the start positions
+	void SearchShiftOrAVX2( const uint64_t* masks, size_t patternSize, const uint8_t* data, size_t size, std::vector<size_t>& results, size_t maxResults ) {
+		const auto positionCount = size - patternSize + 1;
+		const auto laneSize = positionCount / 4;
+		const auto matchBit = _mm256_set1_epi64x( static_cast<int64_t>( 1ull << ( patternSize - 1 ) ) );
+
+		std::vector<size_t> laneResults[4];
+		size_t foundCount = 0;
+		auto state = _mm256_set1_epi64x( -1 );
+		for( size_t step = 0; step < laneSize + patternSize - 1 && results.size( ) + foundCount < maxResults; step++ ) {
+			const auto lane0 = data + step;
+			const auto input = _mm256_set_epi64x(
+				static_cast<int64_t>( masks[lane0[3 * laneSize]] ),
+				static_cast<int64_t>( masks[lane0[2 * laneSize]] ),
+				static_cast<int64_t>( masks[lane0[laneSize]] ),
+				static_cast<int64_t>( masks[lane0[0]] ) );
+			state = _mm256_or_si256( _mm256_slli_epi64( state, 1 ), input );
+
+			const auto hits = _mm256_andnot_si256( state, matchBit );
+			if( !_mm256_testz_si256( hits, hits ) ) {
+				alignas( 32 ) uint64_t laneHits[4];
+				_mm256_store_si256( reinterpret_cast<__m256i*>( laneHits ), hits );
+				for( size_t lane = 0; lane < 4; lane++ ) {
+					if( laneHits[lane] != 0 ) {
+						laneResults[lane].push_back( lane * laneSize + step + 1 - patternSize );
+						foundCount++;
+					}
+				}
+			}
+		}
+		_mm256_zeroupper( );
+
+		for( const auto& lane : laneResults ) {
+			for( const auto offset : lane ) {
+				if( results.size( ) >= maxResults ) {
+					return;
+				}
+				results.push_back( offset );
+			}
+		}
+		if( results.size( ) < maxResults ) {
+			SearchShiftOrScalar( masks, patternSize, data, 4 * laneSize, positionCount, results, maxResults );
+		}
+	}
+}
+
+void FindPatternShiftOr( const CompiledPattern& pattern, const uint8_t* data, size_t size, std::vector<size_t>& results, size_t maxResults ) {
+	if( pattern.size( ) == 0 || size < pattern.size( ) || results.size( ) >= maxResults ) {
+		return;
+	}
+	if( pattern.size( ) > ShiftOrMaximumLength ) {
+		FindPattern( pattern, data, size, results, maxResults );
+		return;
+	}
+
+	uint64_t masks[256];
+	BuildShiftOrMasks( pattern, masks );
+
+	// Lanes only pay off once they are long compared to the pattern
+	const auto positionCount = size - pattern.size( ) + 1;
+	if( GetMatcherLevel( ) >= MatcherLevel::AVX2 && positionCount >= 64 * pattern.size( ) ) {
+		SearchShiftOrAVX2( masks, pattern.size( ), data, size, results, maxResults );
+	}
+	else {
+		SearchShiftOrScalar( masks, pattern.size( ), data, 0, positionCount, results, maxResults );
+	}
+}
+
+const char* GetSearchEngineName( SearchEngine engine ) {
+	switch( engine ) {
+	case SearchEngine::Anchor:
+		return "Anchor scan";
+	case SearchEngine::Horspool:
+		return "Horspool";
+	case SearchEngine::ShiftOr:
+		return "Shift-Or";
+	default:
+		return "Automatic";
+	}
+}
+
+bool CanUseSearchEngine( SearchEngine engine, const CompiledPattern& pattern ) {
+	switch( engine ) {
+	case SearchEngine::Horspool:
+		return FindLongestConcreteRun( pattern ).length >= 2;
+	case SearchEngine::ShiftOr:
+		return pattern.size( ) <= ShiftOrMaximumLength;
+	default:
+		return true;
+	}
+}
+
+void FindPatternWithEngine( SearchEngine engine, const CompiledPattern& pattern, const uint8_t* data, size_t size, std::vector<size_t>& results, size_t maxResults ) {
+	switch( engine ) {
+	case SearchEngine::Horspool:
+		FindPatternHorspool( pattern, data, size, results, maxResults );
+		break;
+	case SearchEngine::ShiftOr:
+		FindPatternShiftOr( pattern, data, size, results, maxResults );
+		break;
+	default:
+		FindPattern( pattern, data, size, results, maxResults );
+		break;
+	}
+}
+
+size_t CountPatternMismatches( const CompiledPattern& pattern, const uint8_t* data, size_t limit ) {
+	const auto length = pattern.size( );
+	const auto bytes = pattern.bytes.data( );
+	const auto mask = pattern.mask.data( );
+
+	// Count the non-zero bytes of the masked difference 8 bytes at a time
+	size_t mismatches = 0;
+	size_t i = 0;
+	for( ; i + 8 <= length && mismatches <= limit; i += 8 ) {
+		uint64_t value, expected, compareMask;
+		memcpy( &value, data + i, 8 );
+		memcpy( &expected, bytes + i, 8 );
+		memcpy( &compareMask, mask + i, 8 );
+		auto difference = ( value & compareMask ) ^ expected;
+		difference |= difference >> 4;
+		difference |= difference >> 2;
+		difference |= difference >> 1;
+		mismatches += std::popcount( difference & 0x0101010101010101ull );
+	}
+	for( ; i < length && mismatches <= limit; i++ ) {
+		if( ( data[i] & mask[i] ) != bytes[i] ) {
+			mismatches++;
+		}
+	}
+	return mismatches;
+}
+
+std::vector<PatternPiece> SplitPattern( const CompiledPattern& pattern, size_t pieceCount ) {
+	std::vector<PatternPiece> pieces;
+	size_t definedCount = 0;
+	for( const auto mask : pattern.mask ) {
+		definedCount += mask != 0;
+	}
+	if( pieceCount == 0 || pieceCount > definedCount ) {
+		return pieces;
+	}
+
+	size_t position = 0;
+	size_t definedSeen = 0;
+	for( size_t piece = 0; piece < pieceCount; piece++ ) {
+		// Leading wildcards only shift the piece
+		while( pattern.mask[position] == 0 ) {
+			position++;
+		}
+
+		pieces.push_back( { position, { } } );
+		auto& current = pieces.back( );
+		const auto definedEnd = definedCount * ( piece + 1 ) / pieceCount;
+		for( ; definedSeen < definedEnd; position++ ) {
+			AppendPatternByte( current.pattern, pattern.bytes[position], pattern.mask[position] );
+			definedSeen += pattern.mask[position] != 0;
+		}
+		SelectPatternAnchors( current.pattern );
+	}
+	return pieces;
+}
@@ -0,0 +1,98 @@
+#pragma once
+#include <vector>
+#include <array>
+#include <cstdint>
+#include <cstddef>
+
+// Byte pattern with a compare mask per byte, prepared for the vectorized search kernels
+struct CompiledPattern {
+	std::vector<uint8_t> bytes; // Already masked
+	std::vector<uint8_t> mask; // 0xFF compares the whole byte, 0x00 is a wildcard, nibble masks are allowed
+
+	// Fully defined bytes the kernels scan for before verifying the whole pattern
+	size_t anchorOffset = 0;
+	size_t secondAnchorOffset = 0;
+	bool hasAnchor = false;
+	bool hasSecondAnchor = false;
+
+	size_t size( ) const {
+		return bytes.size( );
+	}
+};
+
+// Byte and byte pair frequencies of the searched data, used to pick the anchors with the fewest expected hits
+struct ByteHistogram {
+	std::array<uint64_t, 256> byteCounts{};
+	std::vector<uint64_t> pairCounts = std::vector<uint64_t>( 256 * 256 ); // Indexed by first byte << 8 | second byte
+	uint64_t size = 0;
+};
+
+void AddToByteHistogram( ByteHistogram& histogram, const uint8_t* data, size_t size );
+void MergeByteHistogram( ByteHistogram& histogram, const ByteHistogram& other );
+
+// Histogram SelectPatternAnchors ranks bytes by, nullptr treats all bytes as equally common
+void SetAnchorHistogram( const ByteHistogram* histogram );
+
+// Instruction sets the search kernels can use, picked once at runtime via cpuid
+enum class MatcherLevel : uint32_t {
+	Scalar = 0,
+	SSE2,
+	AVX2,
+	AVX512
+};
+
+MatcherLevel GetMatcherLevel( );
+const char* GetMatcherLevelName( MatcherLevel level );
+
+// Add a byte to the pattern, invalidates the anchors
+void AppendPatternByte( CompiledPattern& pattern, uint8_t value, uint8_t mask );
+
+// Pick the pair of fully defined bytes with the fewest expected occurences as anchors, has to be called before searching
+void SelectPatternAnchors( CompiledPattern& pattern );
+
+// Check the whole pattern at data, data must have at least pattern.size( ) bytes
+bool IsPatternMatch( const CompiledPattern& pattern, const uint8_t* data );
+
+// Search data for the pattern and append the match offsets to results until maxResults are reached
+void FindPattern( const CompiledPattern& pattern, const uint8_t* data, size_t size, std::vector<size_t>& results, size_t maxResults );
+
+// Longest run of fully defined bytes, the last one if several are equally long
+struct ConcreteRun {
+	size_t offset = 0;
+	size_t length = 0;
+};
+ConcreteRun FindLongestConcreteRun( const CompiledPattern& pattern );
+
+// Horspool search for the longest concrete run with every hit verified against the whole pattern
+// Skips up to the run length per step, so it beats the anchor scan for long runs
+void FindPatternHorspool( const CompiledPattern& pattern, const uint8_t* data, size_t size, std::vector<size_t>& results, size_t maxResults );
+
+// Shift-Or automaton for patterns of up to 64 bytes. Wildcards and nibble masks are folded into the per-byte state masks, so hits need no verification.
+// With AVX2 four automatons scan four parts of the data at once, a result limit then only guarantees ascending but not the first matches
+constexpr size_t ShiftOrMaximumLength = 64;
+void FindPatternShiftOr( const CompiledPattern& pattern, const uint8_t* data, size_t size, std::vector<size_t>& results, size_t maxResults );
+
+// Search algorithms that can be selected per pattern
+enum class SearchEngine : uint32_t {
+	Automatic = 0, // Left to the caller's planner, searched like Anchor if passed on
+	Anchor,
+	Horspool,
+	ShiftOr
+};
+
+const char* GetSearchEngineName( SearchEngine engine );
+bool CanUseSearchEngine( SearchEngine engine, const CompiledPattern& pattern );
+void FindPatternWithEngine( SearchEngine engine, const CompiledPattern& pattern, const uint8_t* data, size_t size, std::vector<size_t>& results, size_t maxResults );
+
+// Number of bytes at data that differ from the pattern, counting stops once limit is exceeded
+size_t CountPatternMismatches( const CompiledPattern& pattern, const uint8_t* data, size_t limit );
+
+// Part of a pattern and where it starts inside the pattern
+struct PatternPiece {
+	size_t offset;
+	CompiledPattern pattern;
+};
+
+// Split the defined bytes evenly into pieceCount pieces with anchors selected, empty if there are fewer defined bytes than pieces.
+// A location with less than pieceCount differing bytes matches at least one piece exactly
+std::vector<PatternPiece> SplitPattern( const CompiledPattern& pattern, size_t pieceCount );
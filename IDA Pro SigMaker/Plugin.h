@@ -8,10 +8,14 @@
 
 // Plugin specific definitions
 
-struct plugin_ctx_t : public plugmod_t {
-	~plugin_ctx_t( ) {
+struct plugin_ctx_t : public plugmod_t, public event_listener_t {
+	plugin_ctx_t( ) {
+		// Listen for database changes to invalidate cached data
+		hook_event_listener( HT_IDB, this );
 	}
+	~plugin_ctx_t( );
 	virtual bool idaapi run( size_t ) override;
+	virtual ssize_t idaapi on_event( ssize_t code, va_list va ) override;
 };
 
 static plugmod_t* idaapi init( ) {
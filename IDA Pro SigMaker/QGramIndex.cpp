@@ -0,0 +1,191 @@
+#include "QGramIndex.h"
+#include <algorithm>
+#include <execution>
+#include <cstring>
+
+namespace {
+	size_t GetVarintSize( uint32_t value ) {
+		size_t size = 1;
+		for( ; value >= 0x80; value >>= 7 ) {
+			size++;
+		}
+		return size;
+	}
+
+	void WriteVarint( uint8_t*& output, uint32_t value ) {
+		while( value >= 0x80 ) {
+			*output++ = static_cast<uint8_t>( value | 0x80 );
+			value >>= 7;
+		}
+		*output++ = static_cast<uint8_t>( value );
+	}
+
+	uint32_t ReadVarint( const uint8_t*& input ) {
+		uint32_t value = 0;
+		for( uint32_t shift = 0; ; shift += 7 ) {
+			const auto byte = *input++;
+			value |= static_cast<uint32_t>( byte & 0x7F ) << shift;
+			if( ( byte & 0x80 ) == 0 ) {
+				return value;
+			}
+		}
+	}
+}
+
+uint32_t QGramIndex::GetBucket( const uint8_t* gram, uint32_t bucketBits ) {
+	uint32_t value;
+	memcpy( &value, gram, sizeof( value ) );
+	return ( value * 0x9E3779B1u ) >> ( 32 - bucketBits );
+}
+
+bool QGramIndex::BuildPart( Part& part ) {
+	// About one bucket per 8 grams keeps the offsets at half a byte per text byte
+	const auto size = part.run.size;
+	part.bucketBits = 8;
+	while( part.bucketBits < 24 && ( 8ull << part.bucketBits ) < size ) {
+		part.bucketBits++;
+	}
+	const size_t bucketCount = 1ull << part.bucketBits;
+	const auto gramCount = size >= GramLength ? size - GramLength + 1 : 0;
+	const auto data = part.run.data;
+
+	// Postings are written in two passes over the grams instead of sorting all positions, so the only
+	// temporary memory is the previous position of every bucket. Positions stay ascending within a bucket
+	std::vector<uint32_t> previousPositions( bucketCount );
+	part.bucketOffsets.assign( bucketCount + 1, 0 );
+	uint64_t postingsSize = 0;
+	for( size_t i = 0; i < gramCount; i++ ) {
+		const auto bucket = GetBucket( data + i, part.bucketBits );
+		const auto deltaSize = GetVarintSize( static_cast<uint32_t>( i ) - previousPositions[bucket] );
+		part.bucketOffsets[bucket + 1] += static_cast<uint32_t>( deltaSize );
+		postingsSize += deltaSize;
+		previousPositions[bucket] = static_cast<uint32_t>( i );
+	}
+	if( postingsSize >= UINT32_MAX ) {
+		return false;
+	}
+	for( size_t i = 0; i < bucketCount; i++ ) {
+		part.bucketOffsets[i + 1] += part.bucketOffsets[i];
+	}
+
+	// Second pass writes each delta at the end of its bucket so far
+	auto nextOffsets = part.bucketOffsets;
+	std::ranges::fill( previousPositions, 0 );
+	part.postings.resize( part.bucketOffsets[bucketCount] );
+	for( size_t i = 0; i < gramCount; i++ ) {
+		const auto bucket = GetBucket( data + i, part.bucketBits );
+		auto output = part.postings.data( ) + nextOffsets[bucket];
+		WriteVarint( output, static_cast<uint32_t>( i ) - previousPositions[bucket] );
+		nextOffsets[bucket] = static_cast<uint32_t>( output - part.postings.data( ) );
+		previousPositions[bucket] = static_cast<uint32_t>( i );
+	}
+	return true;
+}
+
+bool QGramIndex::Build( const std::vector<TextRun>& runs ) {
+	Clear( );
+
+	for( const auto& run : runs ) {
+		if( run.size >= UINT32_MAX ) {
+			return false;
+		}
+		parts.push_back( { run, 0, {}, {} } );
+		textSize += run.size;
+	}
+	if( textSize == 0 ) {
+		return false;
+	}
+	std::ranges::sort( parts, []( const Part& a, const Part& b ) { return a.run.startEA < b.run.startEA; } );
+
+	std::vector<uint8_t> partBuilt( parts.size( ) );
+	std::for_each( std::execution::par, parts.begin( ), parts.end( ), [&]( Part& part ) {
+		partBuilt[&part - parts.data( )] = BuildPart( part );
+	} );
+	if( std::ranges::find( partBuilt, 0 ) != partBuilt.end( ) ) {
+		Clear( );
+		return false;
+	}
+
+	isBuilt = true;
+	return true;
+}
+
+void QGramIndex::Clear( ) {
+	isBuilt = false;
+	textSize = 0;
+	parts = {};
+}
+
+bool QGramIndex::Find( const CompiledPattern& pattern, std::vector<ea_t>& results, size_t maxResults ) const {
+	if( !isBuilt ) {
+		return false;
+	}
+
+	// Total postings size of a gram's buckets is a good estimate for how often it occurs
+	const auto getPostingsSize = [&]( size_t offset ) {
+		size_t postingsSize = 0;
+		for( const auto& part : parts ) {
+			const auto bucket = GetBucket( pattern.bytes.data( ) + offset, part.bucketBits );
+			postingsSize += part.bucketOffsets[bucket + 1] - part.bucketOffsets[bucket];
+		}
+		return postingsSize;
+	};
+
+	size_t gramOffset = SIZE_MAX;
+	size_t bestPostingsSize = SIZE_MAX;
+	for( size_t offset = 0; offset + GramLength <= pattern.size( ); offset++ ) {
+		if( std::any_of( pattern.mask.begin( ) + offset, pattern.mask.begin( ) + offset + GramLength, []( uint8_t mask ) { return mask != 0xFF; } ) ) {
+			continue;
+		}
+		const auto postingsSize = getPostingsSize( offset );
+		if( postingsSize < bestPostingsSize ) {
+			bestPostingsSize = postingsSize;
+			gramOffset = offset;
+		}
+	}
+	if( gramOffset == SIZE_MAX ) {
+		return false;
+	}
+
+	// Buckets also hold colliding grams, every position is verified against the whole pattern
+	for( const auto& part : parts ) {
+		const auto bucket = GetBucket( pattern.bytes.data( ) + gramOffset, part.bucketBits );
+		auto input = part.postings.data( ) + part.bucketOffsets[bucket];
+		const auto end = part.postings.data( ) + part.bucketOffsets[bucket + 1];
+		size_t position = 0;
+		while( input < end ) {
+			position += ReadVarint( input );
+			if( position < gramOffset ) {
+				continue;
+			}
+			const auto start = position - gramOffset;
+			if( start + pattern.size( ) > part.run.size ) {
+				break;
+			}
+			if( IsPatternMatch( pattern, part.run.data + start ) ) {
+				results.push_back( part.run.startEA + start );
+				if( results.size( ) >= maxResults ) {
+					return true;
+				}
+			}
+		}
+	}
+	return true;
+}
+
+bool QGramIndex::Contains( ea_t ea ) const {
+	auto it = std::upper_bound( parts.begin( ), parts.end( ), ea, []( ea_t value, const Part& part ) { return value < part.run.startEA; } );
+	if( it == parts.begin( ) ) {
+		return false;
+	}
+	--it;
+	return ea < it->run.startEA + it->run.size;
+}
+
+size_t QGramIndex::GetMemoryUsage( ) const {
+	size_t memoryUsage = parts.capacity( ) * sizeof( Part );
+	for( const auto& part : parts ) {
+		memoryUsage += part.bucketOffsets.capacity( ) * sizeof( uint32_t ) + part.postings.capacity( );
+	}
+	return memoryUsage;
+}
@@ -0,0 +1,57 @@
+#pragma once
+#include <vector>
+#include <cstdint>
+#include <cstddef>
+
+#include "Plugin.h"
+#include "PatternMatcher.h"
+
+// Posting lists of all 4-byte grams over a set of byte runs, a lighter alternative to SuffixIndex.
+// Grams are hashed into buckets, positions are delta and varint encoded, memory stays around the size of the text
+class QGramIndex {
+public:
+	static constexpr size_t GramLength = 4;
+
+	// Bytes of one run map linearly to addresses, matches never cross runs
+	struct TextRun {
+		ea_t startEA;
+		const uint8_t* data;
+		size_t size;
+	};
+
+	// Runs are indexed in parallel. Their bytes are not copied and have to stay valid until Clear
+	// Returns false if a run is too large for 32-bit positions
+	bool Build( const std::vector<TextRun>& runs );
+	void Clear( );
+	bool IsBuilt( ) const {
+		return isBuilt;
+	}
+
+	// Find all occurences by the postings of the rarest gram of fully defined bytes, verifying each position
+	// Returns false if the pattern has no GramLength fully defined bytes in a row
+	bool Find( const CompiledPattern& pattern, std::vector<ea_t>& results, size_t maxResults ) const;
+
+	// Whether ea is covered by one of the indexed runs
+	bool Contains( ea_t ea ) const;
+
+	size_t GetTextSize( ) const {
+		return textSize;
+	}
+	size_t GetMemoryUsage( ) const;
+
+private:
+	// Postings of one run, bucket i spans postings[bucketOffsets[i]] to postings[bucketOffsets[i + 1]]
+	struct Part {
+		TextRun run;
+		uint32_t bucketBits = 0;
+		std::vector<uint32_t> bucketOffsets;
+		std::vector<uint8_t> postings;
+	};
+
+	static bool BuildPart( Part& part );
+	static uint32_t GetBucket( const uint8_t* gram, uint32_t bucketBits );
+
+	bool isBuilt = false;
+	size_t textSize = 0;
+	std::vector<Part> parts; // Sorted by address
+};
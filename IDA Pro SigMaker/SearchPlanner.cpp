@@ -0,0 +1,133 @@
+#include "SearchPlanner.h"
+#include <algorithm>
+#include <limits>
+
+namespace {
+	// Rough cycle counts, only their ratios matter
+	constexpr double VerifyBaseCost = 4.0;
+	constexpr double VerifyCostPerWord = 1.0;
+	constexpr double HorspoolStepCost = 3.0;
+	constexpr double ShiftOrScalarCost = 1.5;
+	constexpr double ShiftOrVectorCost = 0.6;
+
+	double GetByteProbability( const ByteHistogram* histogram, uint8_t value ) {
+		if( histogram == nullptr || histogram->size == 0 ) {
+			return 1.0 / 256.0;
+		}
+		return static_cast<double>( histogram->byteCounts[value] ) / static_cast<double>( histogram->size );
+	}
+
+	double GetVerifyCost( const CompiledPattern& pattern ) {
+		return VerifyBaseCost + VerifyCostPerWord * static_cast<double>( ( pattern.size( ) + 7 ) / 8 );
+	}
+
+	// Cost of the vector compare per position, without candidates
+	double GetAnchorScanCost( ) {
+		switch( GetMatcherLevel( ) ) {
+		case MatcherLevel::AVX512:
+			return 0.05;
+		case MatcherLevel::AVX2:
+			return 0.08;
+		case MatcherLevel::SSE2:
+			return 0.15;
+		default:
+			return 0.3;
+		}
+	}
+
+	double EstimateAnchorCost( const CompiledPattern& pattern, const ByteHistogram* histogram ) {
+		// No anchor means verifying every position
+		if( !pattern.hasAnchor ) {
+			return GetVerifyCost( pattern );
+		}
+
+		// Probability that a position becomes a candidate, exact for adjacent anchors
+		auto candidateRate = GetByteProbability( histogram, pattern.bytes[pattern.anchorOffset] );
+		if( pattern.hasSecondAnchor && GetMatcherLevel( ) != MatcherLevel::Scalar ) {
+			const auto first = std::min( pattern.anchorOffset, pattern.secondAnchorOffset );
+			const auto second = std::max( pattern.anchorOffset, pattern.secondAnchorOffset );
+			if( second == first + 1 && histogram != nullptr && histogram->size != 0 ) {
+				candidateRate = static_cast<double>( histogram->pairCounts[pattern.bytes[first] << 8 | pattern.bytes[second]] ) / static_cast<double>( histogram->size );
+			}
+			else {
+				candidateRate *= GetByteProbability( histogram, pattern.bytes[pattern.secondAnchorOffset] );
+			}
+		}
+		return GetAnchorScanCost( ) + candidateRate * GetVerifyCost( pattern );
+	}
+
+	double EstimateHorspoolCost( const CompiledPattern& pattern, const ByteHistogram* histogram ) {
+		const auto run = FindLongestConcreteRun( pattern );
+		if( run.length < 2 ) {
+			return std::numeric_limits<double>::infinity( );
+		}
+
+		// Expected shift is the shift table weighted by how often each byte occurs
+		std::array<double, 256> shifts;
+		shifts.fill( static_cast<double>( run.length ) );
+		for( size_t i = 0; i + 1 < run.length; i++ ) {
+			shifts[pattern.bytes[run.offset + i]] = static_cast<double>( run.length - 1 - i );
+		}
+		double expectedShift = 0.0;
+		for( size_t value = 0; value < 256; value++ ) {
+			expectedShift += GetByteProbability( histogram, static_cast<uint8_t>( value ) ) * shifts[value];
+		}
+		expectedShift = std::max( expectedShift, 1.0 );
+
+		const auto lastRate = GetByteProbability( histogram, pattern.bytes[run.offset + run.length - 1] );
+		return ( HorspoolStepCost + lastRate * GetVerifyCost( pattern ) ) / expectedShift;
+	}
+
+	double EstimateShiftOrCost( const CompiledPattern& pattern ) {
+		if( pattern.size( ) > ShiftOrMaximumLength ) {
+			return std::numeric_limits<double>::infinity( );
+		}
+		return GetMatcherLevel( ) >= MatcherLevel::AVX2 ? ShiftOrVectorCost : ShiftOrScalarCost;
+	}
+}
+
+double EstimateSearchCost( SearchEngine engine, const CompiledPattern& pattern, const ByteHistogram* histogram ) {
+	switch( engine ) {
+	case SearchEngine::Horspool:
+		return EstimateHorspoolCost( pattern, histogram );
+	case SearchEngine::ShiftOr:
+		return EstimateShiftOrCost( pattern );
+	default:
+		return EstimateAnchorCost( pattern, histogram );
+	}
+}
+
+SearchPlan PlanPatternSearch( const CompiledPattern& pattern, const ByteHistogram* histogram, bool indexAvailable ) {
+	SearchPlan plan;
+	plan.useIndex = indexAvailable && pattern.hasAnchor;
+	plan.estimatedCost = std::numeric_limits<double>::infinity( );
+	for( const auto engine : { SearchEngine::Anchor, SearchEngine::Horspool, SearchEngine::ShiftOr } ) {
+		const auto cost = EstimateSearchCost( engine, pattern, histogram );
+		if( cost < plan.estimatedCost ) {
+			plan.engine = engine;
+			plan.estimatedCost = cost;
+		}
+	}
+	return plan;
+}
+
+void SearchPlanAudit::Record( const SearchPlan& plan, size_t scannedBytes, size_t resultCount, double milliseconds ) {
+	std::scoped_lock lock( mutex );
+	auto& engineStatistics = statistics[static_cast<size_t>( plan.engine )];
+	engineStatistics.searchCount++;
+	engineStatistics.indexedCount += plan.useIndex;
+	engineStatistics.scannedBytes += scannedBytes;
+	engineStatistics.resultCount += resultCount;
+	engineStatistics.estimatedCost += plan.estimatedCost;
+	engineStatistics.milliseconds += milliseconds;
+}
+
+void SearchPlanAudit::Clear( ) {
+	std::scoped_lock lock( mutex );
+	statistics = { };
+}
+
+SearchPlanAudit::EngineStatistics SearchPlanAudit::GetStatistics( SearchEngine engine ) const {
+	std::scoped_lock lock( mutex );
+	return statistics[static_cast<size_t>( engine )];
+}
@@ -0,0 +1,44 @@
+#pragma once
+#include <vector>
+#include <array>
+#include <mutex>
+#include <cstdint>
+#include <cstddef>
+
+#include "PatternMatcher.h"
+
+// How one pattern gets searched
+struct SearchPlan {
+	SearchEngine engine = SearchEngine::Anchor;
+	bool useIndex = false; // Answer the indexed regions from the suffix array, scan only the rest
+	double estimatedCost = 0.0; // Estimated cycles per scanned byte of the engine
+};
+
+// Estimated cycles per scanned byte, infinite if the engine can't search the pattern.
+// Byte probabilities come from the histogram, nullptr assumes uniformly distributed bytes
+double EstimateSearchCost( SearchEngine engine, const CompiledPattern& pattern, const ByteHistogram* histogram );
+
+// Pick the cheapest engine for the pattern. The index is used whenever it is available and the pattern has a fully defined byte
+SearchPlan PlanPatternSearch( const CompiledPattern& pattern, const ByteHistogram* histogram, bool indexAvailable );
+
+// Executed plans with their timings, to check the cost estimates against reality. Safe to use from multiple threads
+class SearchPlanAudit {
+public:
+	struct EngineStatistics {
+		size_t searchCount = 0;
+		size_t indexedCount = 0;
+		size_t scannedBytes = 0;
+		size_t resultCount = 0;
+		double estimatedCost = 0.0; // Sum over all searches, divide by searchCount
+		double milliseconds = 0.0;
+	};
+
+	void Record( const SearchPlan& plan, size_t scannedBytes, size_t resultCount, double milliseconds );
+	void Clear( );
+
+	EngineStatistics GetStatistics( SearchEngine engine ) const;
+
+private:
+	mutable std::mutex mutex;
+	std::array<EngineStatistics, 4> statistics; // Indexed by SearchEngine
+};
@@ -0,0 +1,140 @@
+#include "Signature.h"
+#include <array>
+#include <cstring>
+
+namespace {
+	// Expands 8 wildcard bits to a mask of the bytes that have to be compared
+	constexpr std::array<uint64_t, 256> CreateCompareMasks( ) {
+		std::array<uint64_t, 256> masks{};
+		for( size_t bits = 0; bits < masks.size( ); bits++ ) {
+			for( size_t i = 0; i < 8; i++ ) {
+				if( ( bits & ( 1ull << i ) ) == 0 ) {
+					masks[bits] |= 0xFFull << ( i * 8 );
+				}
+			}
+		}
+		return masks;
+	}
+
+	constexpr auto CompareMasks = CreateCompareMasks( );
+}
+
+void Signature::clear( ) {
+	count = 0;
+	isInline = true;
+	inlineMask = 0;
+	heapBytes = {};
+	heapMask = {};
+}
+
+void Signature::MoveToHeap( ) {
+	if( !isInline ) {
+		return;
+	}
+	heapBytes.assign( inlineBytes, inlineBytes + count );
+	heapMask.assign( 1, inlineMask );
+	isInline = false;
+}
+
+void Signature::resize( size_t newSize ) {
+	if( newSize > InlineCapacity ) {
+		MoveToHeap( );
+	}
+
+	if( isInline ) {
+		if( newSize > count ) {
+			memset( inlineBytes + count, 0, newSize - count );
+		}
+		else if( newSize < InlineCapacity ) {
+			inlineMask &= ( 1ull << newSize ) - 1;
+		}
+	}
+	else {
+		heapBytes.resize( newSize );
+		heapMask.resize( ( newSize + 63 ) / 64, 0 );
+		if( newSize < count && ( newSize % 64 ) != 0 ) {
+			heapMask.back( ) &= ( 1ull << ( newSize % 64 ) ) - 1;
+		}
+	}
+	count = newSize;
+}
+
+void Signature::Set( size_t index, uint8_t value, bool isWildcard ) {
+	GetMutableBytes( )[index] = value;
+	auto& word = GetMutableWildcardMask( )[index / 64];
+	if( isWildcard ) {
+		word |= 1ull << ( index % 64 );
+	}
+	else {
+		word &= ~( 1ull << ( index % 64 ) );
+	}
+}
+
+void Signature::Append( uint8_t value, bool isWildcard ) {
+	resize( count + 1 );
+	Set( count - 1, value, isWildcard );
+}
+
+void Signature::Append( const uint8_t* bytes, size_t length, bool isWildcard ) {
+	const auto offset = count;
+	resize( count + length );
+	memcpy( GetMutableBytes( ) + offset, bytes, length );
+	if( isWildcard ) {
+		const auto mask = GetMutableWildcardMask( );
+		for( auto i = offset; i < count; i++ ) {
+			mask[i / 64] |= 1ull << ( i % 64 );
+		}
+	}
+}
+
+void Signature::Append( const Signature& other, size_t offset, size_t length ) {
+	const auto start = count;
+	resize( count + length );
+	memcpy( GetMutableBytes( ) + start, other.GetBytes( ) + offset, length );
+	const auto mask = GetMutableWildcardMask( );
+	for( size_t i = 0; i < length; i++ ) {
+		if( other.IsWildcard( offset + i ) ) {
+			mask[( start + i ) / 64] |= 1ull << ( ( start + i ) % 64 );
+		}
+	}
+}
+
+void Signature::Prepend( const Signature& other ) {
+	Signature result = other;
+	result.Append( *this, 0, count );
+	*this = std::move( result );
+}
+
+void Signature::EraseFront( size_t length ) {
+	Signature result;
+	result.Append( *this, length, count - length );
+	*this = std::move( result );
+}
+
+bool Signature::Matches( const uint8_t* data, size_t startOffset ) const {
+	const auto bytes = GetBytes( );
+	const auto mask = GetWildcardMask( );
+
+	// 8 bytes at a time, wildcards are masked out of the difference
+	auto i = startOffset;
+	for( ; i + 8 <= count; i += 8 ) {
+		uint64_t signatureWord, dataWord;
+		memcpy( &signatureWord, bytes + i, sizeof( signatureWord ) );
+		memcpy( &dataWord, data + ( i - startOffset ), sizeof( dataWord ) );
+
+		// The 8 wildcard bits can straddle two mask words
+		auto wildcardBits = mask[i / 64] >> ( i % 64 );
+		if( ( i % 64 ) > 56 ) {
+			wildcardBits |= mask[i / 64 + 1] << ( 64 - ( i % 64 ) );
+		}
+		if( ( ( signatureWord ^ dataWord ) & CompareMasks[wildcardBits & 0xFF] ) != 0 ) {
+			return false;
+		}
+	}
+	for( ; i < count; i++ ) {
+		if( !IsWildcard( i ) && bytes[i] != data[i - startOffset] ) {
+			return false;
+		}
+	}
+	return true;
+}
@@ -0,0 +1,64 @@
+#pragma once
+#include <vector>
+#include <cstdint>
+#include <cstddef>
+
+// Signature bytes and a wildcard bit per byte, stored separately so they can be compared word by word
+// Signatures of up to InlineCapacity bytes need no heap allocation
+class Signature {
+public:
+	static constexpr size_t InlineCapacity = 64;
+
+	size_t size( ) const {
+		return count;
+	}
+	bool empty( ) const {
+		return count == 0;
+	}
+	void clear( );
+	// New bytes are zero and not wildcarded
+	void resize( size_t newSize );
+
+	const uint8_t* GetBytes( ) const {
+		return isInline ? inlineBytes : heapBytes.data( );
+	}
+	// Bit i of word i / 64 is set if byte i is a wildcard
+	const uint64_t* GetWildcardMask( ) const {
+		return isInline ? &inlineMask : heapMask.data( );
+	}
+
+	uint8_t GetByte( size_t index ) const {
+		return GetBytes( )[index];
+	}
+	bool IsWildcard( size_t index ) const {
+		return ( GetWildcardMask( )[index / 64] >> ( index % 64 ) ) & 1;
+	}
+	void Set( size_t index, uint8_t value, bool isWildcard );
+
+	void Append( uint8_t value, bool isWildcard );
+	void Append( const uint8_t* bytes, size_t length, bool isWildcard );
+	// Append length bytes of other, starting at offset
+	void Append( const Signature& other, size_t offset, size_t length );
+	void Prepend( const Signature& other );
+	void EraseFront( size_t length );
+
+	// Compare the bytes from startOffset on against data, which has to hold size( ) - startOffset bytes
+	bool Matches( const uint8_t* data, size_t startOffset = 0 ) const;
+
+private:
+	uint8_t* GetMutableBytes( ) {
+		return isInline ? inlineBytes : heapBytes.data( );
+	}
+	uint64_t* GetMutableWildcardMask( ) {
+		return isInline ? &inlineMask : heapMask.data( );
+	}
+	void MoveToHeap( );
+
+	// Wildcard bits past the end are always zero
+	size_t count = 0;
+	bool isInline = true;
+	alignas( 16 ) uint8_t inlineBytes[InlineCapacity] = {};
+	uint64_t inlineMask = 0;
+	std::vector<uint8_t> heapBytes;
+	std::vector<uint64_t> heapMask;
+};
@@ -3,12 +3,12 @@
 std::string BuildIDASignatureString( const Signature& signature, bool doubleQM ) {
 	std::ostringstream result;
 	// Build hex pattern
-	for( const auto& byte : signature ) {
-		if( byte.isWildcard ) {
+	for( size_t i = 0; i < signature.size( ); i++ ) {
+		if( signature.IsWildcard( i ) ) {
 			result << ( doubleQM ? "??" : "?" );
 		}
 		else {
-			result << std::format( "{:02X}", byte.value );
+			result << std::format( "{:02X}", signature.GetByte( i ) );
 		}
 		result << " ";
 	}
@@ -24,9 +24,10 @@ std::string BuildByteArrayWithMaskSignatureString( const Signature& signature )
 	std::ostringstream pattern;
 	std::ostringstream mask;
 	// Build hex pattern
-	for( const auto& byte : signature ) {
-		pattern << "\\x" << std::format( "{:02X}", ( byte.isWildcard ? 0 : byte.value ) );
-		mask << ( byte.isWildcard ? "?" : "x" );
+	for( size_t i = 0; i < signature.size( ); i++ ) {
+		const auto isWildcard = signature.IsWildcard( i );
+		pattern << "\\x" << std::format( "{:02X}", ( isWildcard ? 0 : signature.GetByte( i ) ) );
+		mask << ( isWildcard ? "?" : "x" );
 	}
 	auto str = pattern.str( ) + " " + mask.str( );
 	return str;
@@ -39,11 +40,11 @@ std::string BuildBytesWithBitmaskSignatureString( const Signature& signature ) {
 	pattern << "\{";
 	for (int i = 0; i < signature.size(); i++)
 	{
-		auto byte = signature.at(i);
-		pattern << "0x" << std::format("{:02X}", (byte.isWildcard ? 0 : byte.value));
+		const auto isWildcard = signature.IsWildcard(i);
+		pattern << "0x" << std::format("{:02X}", (isWildcard ? 0 : signature.GetByte(i)));
 		if (i != signature.size() - 1)
 			pattern << ", ";
-		mask << (byte.isWildcard ? "0" : "1");
+		mask << (isWildcard ? "0" : "1");
 	}
 	auto patternStr = pattern.str( );
 	auto maskStr = mask.str( );
@@ -78,22 +79,40 @@ std::string FormatSignature( const Signature& signature, SignatureType type ) {
 
 
 void AddByteToSignature( Signature& signature, ea_t address, bool wildcard ) {
-	SignatureByte byte{};
-	byte.isWildcard = wildcard;
-	byte.value = get_byte( address );
-	signature.push_back( byte );
+	signature.Append( get_byte( address ), wildcard );
 }
 
 void AddBytesToSignature( Signature& signature, ea_t address, size_t count, bool wildcard ) {
-	// signature.reserve( signature.size() + count ); // Not sure if this is overhead for average signature creation
-	for( size_t i = 0; i < count; i++ ) {
-		AddByteToSignature( signature, address + i, wildcard );
-	}
+	// One bulk read instead of a get_byte call per byte
+	std::vector<uint8_t> bytes( count );
+	get_bytes( bytes.data( ), count, address, GMB_READALL );
+	AddBytesToSignature( signature, bytes.data( ), count, wildcard );
+}
+
+void AddBytesToSignature( Signature& signature, const uint8_t* bytes, size_t count, bool wildcard ) {
+	signature.Append( bytes, count, wildcard );
 }
 
 
 // Trim wildcards at end
 void TrimSignature( Signature& signature ) {
-	auto it = std::find_if( signature.rbegin( ), signature.rend( ), []( const auto& sb ) { return !sb.isWildcard; } );
-	signature.erase( it.base( ), signature.end( ) );
+	auto newSize = signature.size( );
+	while( newSize > 0 && signature.IsWildcard( newSize - 1 ) ) {
+		newSize--;
+	}
+	signature.resize( newSize );
+}
+
+// Append the signature bytes from startOffset on, so a growing signature does not have to be compiled again
+void AppendSignatureToPattern( CompiledPattern& pattern, const Signature& signature, size_t startOffset ) {
+	for( size_t i = startOffset; i < signature.size( ); i++ ) {
+		AppendPatternByte( pattern, signature.GetByte( i ), signature.IsWildcard( i ) ? 0x00 : 0xFF );
+	}
+}
+
+CompiledPattern CompileSignature( const Signature& signature ) {
+	CompiledPattern pattern;
+	AppendSignatureToPattern( pattern, signature );
+	SelectPatternAnchors( pattern );
+	return pattern;
 }
@@ -10,4 +10,9 @@ std::string FormatSignature( const Signature& signature, SignatureType type );
 // Utility functions
 void AddByteToSignature( Signature& signature, ea_t address, bool wildcard );
 void AddBytesToSignature( Signature& signature, ea_t address, size_t count, bool wildcard );
-void TrimSignature( Signature& signature );
\ No newline at end of file
+void AddBytesToSignature( Signature& signature, const uint8_t* bytes, size_t count, bool wildcard );
+void TrimSignature( Signature& signature );
+
+// Search pattern functions
+void AppendSignatureToPattern( CompiledPattern& pattern, const Signature& signature, size_t startOffset = 0 );
+CompiledPattern CompileSignature( const Signature& signature );
\ No newline at end of file
@@ -0,0 +1,304 @@
+#include "SuffixIndex.h"
+#include <algorithm>
+#include <execution>
+#include <numeric>
+#include <cstring>
+
+namespace {
+	// First 8 bytes of the suffix, big endian so integer order equals lexicographic order. Bytes past the end of the run are 0
+	uint64_t GetPrefixKey( const uint8_t* text, size_t remaining ) {
+		uint64_t key = 0;
+		for( size_t i = 0; i < 8; i++ ) {
+			key <<= 8;
+			if( i < remaining ) {
+				key |= text[i];
+			}
+		}
+		return key;
+	}
+}
+
+size_t SuffixIndex::GetRunEnd( size_t position ) const {
+	const auto run = FindRunByTextOffset( position );
+	return run->textOffset + run->size;
+}
+
+const uint8_t* SuffixIndex::GetText( size_t position ) const {
+	const auto run = FindRunByTextOffset( position );
+	return run->data + ( position - run->textOffset );
+}
+
+// Prefix doubling: sort by the first 8 bytes, then repeatedly sort each group of equal ranks by the rank k positions ahead
+// Groups are independent of each other, so they are sorted in parallel. inverseSuffixArray holds the ranks while building
+void SuffixIndex::BuildSuffixArray( ) {
+	const auto n = textSize;
+	auto& rank = inverseSuffixArray;
+	suffixArray.resize( n );
+	rank.resize( n );
+	std::iota( suffixArray.begin( ), suffixArray.end( ), 0 );
+
+	std::vector<uint64_t> prefixKeys( n );
+	std::for_each( std::execution::par, runs.begin( ), runs.end( ), [&]( const Run& run ) {
+		for( size_t i = 0; i < run.size; i++ ) {
+			prefixKeys[run.textOffset + i] = GetPrefixKey( run.data + i, run.size - i );
+		}
+	} );
+	std::sort( std::execution::par, suffixArray.begin( ), suffixArray.end( ), [&]( uint32_t a, uint32_t b ) {
+		return prefixKeys[a] < prefixKeys[b];
+	} );
+
+	// The rank of a suffix is the start index of its group, unsorted groups are collected for the next round
+	std::vector<std::pair<uint32_t, uint32_t>> groups;
+	for( size_t start = 0; start < n; ) {
+		const auto key = prefixKeys[suffixArray[start]];
+		auto end = start + 1;
+		while( end < n && prefixKeys[suffixArray[end]] == key ) {
+			end++;
+		}
+		for( auto i = start; i < end; i++ ) {
+			rank[suffixArray[i]] = static_cast<uint32_t>( start );
+		}
+		if( end - start > 1 ) {
+			groups.emplace_back( static_cast<uint32_t>( start ), static_cast<uint32_t>( end ) );
+		}
+		start = end;
+	}
+	prefixKeys = {};
+
+	std::vector<uint32_t> newRank;
+	std::vector<std::pair<uint32_t, uint32_t>> newGroups;
+	for( size_t k = 8; !groups.empty( ); k *= 2 ) {
+		// Suffixes that end within k bytes have equal padded prefixes, order them by length, shorter first.
+		// Equally long ones are equal strings in different runs, their position keeps the order strict so every group splits up
+		const auto secondKey = [&]( uint32_t position ) -> uint64_t {
+			const auto runEnd = GetRunEnd( position );
+			if( position + k < runEnd ) {
+				return ( static_cast<uint64_t>( k + 1 ) << 32 ) + rank[position + k];
+			}
+			return ( static_cast<uint64_t>( runEnd - position ) << 32 ) + position;
+		};
+
+		std::for_each( std::execution::par, groups.begin( ), groups.end( ), [&]( const std::pair<uint32_t, uint32_t>& group ) {
+			std::sort( suffixArray.begin( ) + group.first, suffixArray.begin( ) + group.second, [&]( uint32_t a, uint32_t b ) {
+				return secondKey( a ) < secondKey( b );
+			} );
+		} );
+
+		// Ranks of the last round are still needed by the sort keys, so compute the new ones separately
+		newRank = rank;
+		newGroups.clear( );
+		for( const auto& [groupStart, groupEnd] : groups ) {
+			for( auto start = groupStart; start < groupEnd; ) {
+				const auto key = secondKey( suffixArray[start] );
+				auto end = start + 1;
+				while( end < groupEnd && secondKey( suffixArray[end] ) == key ) {
+					end++;
+				}
+				for( auto i = start; i < end; i++ ) {
+					newRank[suffixArray[i]] = start;
+				}
+				if( end - start > 1 ) {
+					newGroups.emplace_back( start, end );
+				}
+				start = end;
+			}
+		}
+		rank.swap( newRank );
+		groups.swap( newGroups );
+	}
+}
+
+// Kasai et al., comparisons stop at the end of either run
+void SuffixIndex::BuildLCPArray( ) {
+	const auto n = textSize;
+	lcpArray.assign( n, 0 );
+	size_t h = 0;
+	for( const auto& run : runs ) {
+		for( size_t offset = 0; offset < run.size; offset++ ) {
+			const auto i = run.textOffset + offset;
+			const auto rank = inverseSuffixArray[i];
+			if( rank == 0 ) {
+				h = 0;
+				continue;
+			}
+			const size_t j = suffixArray[rank - 1];
+			const auto iText = run.data + offset;
+			const auto jText = GetText( j );
+			const auto iRemaining = run.size - offset;
+			const auto jRemaining = GetRunEnd( j ) - j;
+			while( h < iRemaining && h < jRemaining && iText[h] == jText[h] ) {
+				h++;
+			}
+			lcpArray[rank] = static_cast<uint32_t>( h );
+			if( h > 0 ) {
+				h--;
+			}
+		}
+	}
+}
+
+bool SuffixIndex::Build( const std::vector<TextRun>& textRuns ) {
+	Clear( );
+
+	size_t totalSize = 0;
+	for( const auto& run : textRuns ) {
+		totalSize += run.size;
+	}
+	if( totalSize == 0 || totalSize >= UINT32_MAX ) {
+		return false;
+	}
+
+	for( const auto& run : textRuns ) {
+		if( run.size == 0 ) {
+			continue;
+		}
+		runs.push_back( { run.startEA, textSize, run.size, run.data } );
+		textSize += run.size;
+	}
+
+	BuildSuffixArray( );
+	BuildLCPArray( );
+
+	isBuilt = true;
+	return true;
+}
+
+void SuffixIndex::Clear( ) {
+	isBuilt = false;
+	textSize = 0;
+	runs = {};
+	suffixArray = {};
+	inverseSuffixArray = {};
+	lcpArray = {};
+}
+
+size_t SuffixIndex::GetMemoryUsage( ) const {
+	return runs.capacity( ) * sizeof( Run ) + ( suffixArray.capacity( ) + inverseSuffixArray.capacity( ) + lcpArray.capacity( ) ) * sizeof( uint32_t );
+}
+
+std::pair<size_t, size_t> SuffixIndex::FindRange( const uint8_t* bytes, size_t length ) const {
+	// Compare the suffix with the bytes, a suffix shorter than the bytes compares less if it is a prefix of them
+	const auto compare = [&]( uint32_t position ) -> int {
+		const auto run = FindRunByTextOffset( position );
+		const auto available = std::min( length, run->textOffset + run->size - position );
+		const auto result = memcmp( run->data + ( position - run->textOffset ), bytes, available );
+		if( result != 0 ) {
+			return result;
+		}
+		return available < length ? -1 : 0;
+	};
+
+	const auto first = std::partition_point( suffixArray.begin( ), suffixArray.end( ), [&]( uint32_t position ) { return compare( position ) < 0; } );
+	const auto last = std::partition_point( first, suffixArray.end( ), [&]( uint32_t position ) { return compare( position ) == 0; } );
+	return { static_cast<size_t>( first - suffixArray.begin( ) ), static_cast<size_t>( last - suffixArray.begin( ) ) };
+}
+
+const SuffixIndex::Run* SuffixIndex::FindRunByTextOffset( size_t textOffset ) const {
+	auto it = std::upper_bound( runs.begin( ), runs.end( ), textOffset, []( size_t value, const Run& run ) { return value < run.textOffset; } );
+	if( it == runs.begin( ) ) {
+		return nullptr;
+	}
+	return &*( it - 1 );
+}
+
+const SuffixIndex::Run* SuffixIndex::FindRunByAddress( ea_t ea ) const {
+	auto it = std::upper_bound( runs.begin( ), runs.end( ), ea, []( ea_t value, const Run& run ) { return value < run.startEA; } );
+	if( it == runs.begin( ) ) {
+		return nullptr;
+	}
+	--it;
+	return ea < it->startEA + it->size ? &*it : nullptr;
+}
+
+bool SuffixIndex::Contains( ea_t ea ) const {
+	return FindRunByAddress( ea ) != nullptr;
+}
+
+size_t SuffixIndex::GetMinimalUniqueLength( ea_t ea ) const {
+	if( !isBuilt ) {
+		return 0;
+	}
+	const auto run = FindRunByAddress( ea );
+	if( run == nullptr ) {
+		return 0;
+	}
+
+	const auto position = run->textOffset + ( ea - run->startEA );
+	const auto remaining = run->textOffset + run->size - position;
+	const size_t rank = inverseSuffixArray[position];
+
+	// The LCP values already stop at run borders, every neighbour alone bounds the unique length from below
+	size_t commonLength = 0;
+	if( rank > 0 ) {
+		commonLength = lcpArray[rank];
+	}
+	if( rank + 1 < suffixArray.size( ) ) {
+		commonLength = std::max<size_t>( commonLength, lcpArray[rank + 1] );
+	}
+
+	if( commonLength >= remaining ) {
+		return SIZE_MAX;
+	}
+	return commonLength + 1;
+}
+
+bool SuffixIndex::Find( const CompiledPattern& pattern, std::vector<ea_t>& results, size_t maxResults ) const {
+	if( !isBuilt ) {
+		return false;
+	}
+
+	// Split the pattern at wildcards and take the fully defined part with the fewest occurences
+	size_t bestOffset = 0, bestLength = 0;
+	std::pair<size_t, size_t> bestRange{ 0, SIZE_MAX };
+	for( size_t i = 0; i < pattern.size( ); ) {
+		if( pattern.mask[i] != 0xFF ) {
+			i++;
+			continue;
+		}
+		auto end = i;
+		while( end < pattern.size( ) && pattern.mask[end] == 0xFF ) {
+			end++;
+		}
+
+		const auto range = FindRange( pattern.bytes.data( ) + i, end - i );
+		if( range.second - range.first < bestRange.second - bestRange.first ) {
+			bestRange = range;
+			bestOffset = i;
+			bestLength = end - i;
+		}
+		i = end;
+	}
+
+	if( bestLength == 0 ) {
+		return false;
+	}
+
+	// Verify the candidates of that part against the whole pattern
+	std::vector<ea_t> matches;
+	for( auto i = bestRange.first; i < bestRange.second; i++ ) {
+		const size_t position = suffixArray[i];
+		if( position < bestOffset ) {
+			continue;
+		}
+		const auto start = position - bestOffset;
+
+		// Matches must not cross runs
+		const auto run = FindRunByTextOffset( start );
+		if( run == nullptr || start + pattern.size( ) > run->textOffset + run->size ) {
+			continue;
+		}
+		if( !IsPatternMatch( pattern, run->data + ( start - run->textOffset ) ) ) {
+			continue;
+		}
+
+		matches.push_back( run->startEA + ( start - run->textOffset ) );
+		if( results.size( ) + matches.size( ) >= maxResults ) {
+			break;
+		}
+	}
+
+	// Suffix array order is lexicographic, callers expect address order
+	std::ranges::sort( matches );
+	results.insert( results.end( ), matches.begin( ), matches.end( ) );
+	return true;
+}
@@ -0,0 +1,69 @@
+#pragma once
+#include <vector>
+#include <cstdint>
+#include <utility>
+
+#include "Plugin.h"
+#include "PatternMatcher.h"
+
+// Suffix array and LCP array over a set of byte runs, answers pattern queries with a binary search instead of a linear scan
+// The runs are laid out one after another at virtual text positions, every suffix ends at the end of its run
+class SuffixIndex {
+public:
+	// Bytes of one run map linearly to addresses, matches never cross runs
+	struct TextRun {
+		ea_t startEA;
+		const uint8_t* data;
+		size_t size;
+	};
+
+	// Build the index over the runs. Their bytes are not copied and have to stay valid until Clear
+	// Returns false if the text is too large for 32-bit positions
+	bool Build( const std::vector<TextRun>& runs );
+	void Clear( );
+	bool IsBuilt( ) const {
+		return isBuilt;
+	}
+
+	// Find all occurences of the pattern, the pattern needs at least one fully defined byte
+	// Returns false if the pattern can not be answered by the index
+	bool Find( const CompiledPattern& pattern, std::vector<ea_t>& results, size_t maxResults ) const;
+
+	// Half-open range of suffix array entries that start with the given bytes
+	std::pair<size_t, size_t> FindRange( const uint8_t* bytes, size_t length ) const;
+
+	// Whether ea is covered by one of the indexed runs
+	bool Contains( ea_t ea ) const;
+
+	// Lower bound for the length of a unique byte string starting at ea, taken from the LCP of its suffix array neighbours.
+	// Returns 0 if ea is not indexed, SIZE_MAX if no string starting at ea is unique inside its run
+	size_t GetMinimalUniqueLength( ea_t ea ) const;
+
+	size_t GetTextSize( ) const {
+		return textSize;
+	}
+	size_t GetMemoryUsage( ) const;
+
+private:
+	struct Run {
+		ea_t startEA;
+		size_t textOffset;
+		size_t size;
+		const uint8_t* data;
+	};
+
+	void BuildSuffixArray( );
+	void BuildLCPArray( );
+	const Run* FindRunByTextOffset( size_t textOffset ) const;
+	const Run* FindRunByAddress( ea_t ea ) const;
+	// Text position where the run containing position ends
+	size_t GetRunEnd( size_t position ) const;
+	const uint8_t* GetText( size_t position ) const;
+
+	bool isBuilt = false;
+	size_t textSize = 0;
+	std::vector<Run> runs;
+	std::vector<uint32_t> suffixArray;
+	std::vector<uint32_t> inverseSuffixArray;
+	std::vector<uint32_t> lcpArray; // lcpArray[i] is the common prefix length of suffixArray[i - 1] and suffixArray[i]
+};
@@ -47,4 +47,90 @@ bool GetRegexMatches( std::string string, std::regex regex, std::vector<std::str
 		++iter;
 	}
 	return !matches.empty( );
-}
\ No newline at end of file
+}
+
+namespace {
+	thread_local bool IsWorkerThread = false;
+
+	// Set while the thread runs the tasks of its own ParallelFor call and holds jobMutex
+	thread_local bool IsInsideParallelFor = false;
+}
+
+ThreadPool::ThreadPool( size_t threadCount ) {
+	// The calling thread works as well
+	for( size_t i = 1; i < threadCount; i++ ) {
+		workers.emplace_back( &ThreadPool::WorkerLoop, this );
+	}
+}
+
+ThreadPool::~ThreadPool( ) {
+	{
+		std::lock_guard lock( mutex );
+		isStopping = true;
+	}
+	wakeCondition.notify_all( );
+	for( auto& worker : workers ) {
+		worker.join( );
+	}
+}
+
+void ThreadPool::RunTasks( ) {
+	for( auto i = nextTask++; i < taskCount; i = nextTask++ ) {
+		( *currentTask )( i );
+	}
+}
+
+void ThreadPool::WorkerLoop( ) {
+	IsWorkerThread = true;
+	uint64_t lastGeneration = 0;
+	while( true ) {
+		{
+			std::unique_lock lock( mutex );
+			wakeCondition.wait( lock, [&] { return isStopping || generation != lastGeneration; } );
+			if( isStopping ) {
+				return;
+			}
+			lastGeneration = generation;
+		}
+
+		RunTasks( );
+
+		std::lock_guard lock( mutex );
+		if( --busyWorkers == 0 ) {
+			doneCondition.notify_one( );
+		}
+	}
+}
+
+void ThreadPool::ParallelFor( size_t count, const std::function<void( size_t )>& task ) {
+	if( count == 0 ) {
+		return;
+	}
+
+	// Only try_lock when this thread does not own jobMutex already, locking it twice is undefined
+	if( IsWorkerThread || IsInsideParallelFor || workers.empty( ) || count == 1 || !jobMutex.try_lock( ) ) {
+		for( size_t i = 0; i < count; i++ ) {
+			task( i );
+		}
+		return;
+	}
+	std::lock_guard jobLock( jobMutex, std::adopt_lock );
+	IsInsideParallelFor = true;
+
+	{
+		std::lock_guard lock( mutex );
+		currentTask = &task;
+		taskCount = count;
+		nextTask = 0;
+		busyWorkers = workers.size( );
+		generation++;
+	}
+	wakeCondition.notify_all( );
+
+	RunTasks( );
+
+	std::unique_lock lock( mutex );
+	doneCondition.wait( lock, [&] { return busyWorkers == 0; } );
+	currentTask = nullptr;
+	IsInsideParallelFor = false;
+}
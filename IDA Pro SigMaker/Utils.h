@@ -7,6 +7,11 @@
 #include <vector>
 #include <regex>
 #include <string_view>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <atomic>
+#include <functional>
 
 // Generic utility functions
 
@@ -14,4 +19,39 @@ bool SetClipboardText( std::string_view text );
 bool GetRegexMatches( std::string string, std::regex regex, std::vector<std::string>& matches );
 constexpr auto BIT( uint32_t x ) {
     return 1LLU << x;
-}
\ No newline at end of file
+}
+
+// Fixed set of worker threads for data parallel loops
+class ThreadPool {
+public:
+	explicit ThreadPool( size_t threadCount = std::thread::hardware_concurrency( ) );
+	~ThreadPool( );
+
+	ThreadPool( const ThreadPool& ) = delete;
+	ThreadPool& operator=( const ThreadPool& ) = delete;
+
+	// Worker threads plus the calling thread
+	size_t GetThreadCount( ) const {
+		return workers.size( ) + 1;
+	}
+
+	// Calls task( i ) for every i in [0, count) and blocks until all calls returned
+	// Nested calls from tasks, on workers or the calling thread, and concurrent calls run serially on the calling thread
+	void ParallelFor( size_t count, const std::function<void( size_t )>& task );
+
+private:
+	void WorkerLoop( );
+	void RunTasks( );
+
+	std::vector<std::thread> workers;
+	std::mutex jobMutex;
+	std::mutex mutex;
+	std::condition_variable wakeCondition;
+	std::condition_variable doneCondition;
+	const std::function<void( size_t )>* currentTask = nullptr;
+	size_t taskCount = 0;
+	std::atomic<size_t> nextTask = 0;
+	size_t busyWorkers = 0;
+	uint64_t generation = 0;
+	bool isStopping = false;
+};
@@ -0,0 +1,69 @@
+#include "WildcardBitmap.h"
+#include <algorithm>
+
+namespace {
+	void SetBit( uint64_t* bits, size_t index ) {
+		bits[index / 64] |= 1ull << ( index % 64 );
+	}
+
+	// Longer instructions are left out, they are decoded whenever needed
+	constexpr size_t MaxInstructionLength = UINT8_MAX;
+}
+
+void WildcardBitmap::Clear( ) {
+	pages.clear( );
+}
+
+void WildcardBitmap::SetOperandTypeBitmask( uint32_t bitmask ) {
+	if( bitmask != operandTypeBitmask ) {
+		Clear( );
+		operandTypeBitmask = bitmask;
+	}
+}
+
+const WildcardBitmap::Page* WildcardBitmap::FindPage( ea_t ea ) const {
+	const auto it = pages.find( ea / PageSize );
+	return it != pages.end( ) ? it->second.get( ) : nullptr;
+}
+
+WildcardBitmap::Page& WildcardBitmap::GetPage( ea_t ea ) {
+	auto& page = pages[ea / PageSize];
+	if( page == nullptr ) {
+		// Value initialized, so every bit starts out cleared
+		page = std::make_unique<Page>( );
+	}
+	return *page;
+}
+
+bool WildcardBitmap::IsPageDecoded( ea_t ea ) const {
+	const auto page = FindPage( ea );
+	return page != nullptr && page->isDecoded;
+}
+
+void WildcardBitmap::SetPageDecoded( ea_t ea ) {
+	GetPage( ea ).isDecoded = true;
+}
+
+void WildcardBitmap::AddInstruction( ea_t ea, size_t length, size_t operandOffset, size_t operandLength ) {
+	if( length == 0 || length > MaxInstructionLength ) {
+		return;
+	}
+	GetPage( ea ).instructionLengths[ea % PageSize] = static_cast<uint8_t>( length );
+
+	// Same clamping as when adding the instruction to a signature
+	operandOffset = std::min( operandOffset, length );
+	operandLength = std::min( operandLength, length - operandOffset );
+	for( auto i = ea + operandOffset; i < ea + operandOffset + operandLength; i++ ) {
+		SetBit( GetPage( i ).wildcards, i % PageSize );
+	}
+}
+
+size_t WildcardBitmap::GetInstructionLength( ea_t ea ) const {
+	const auto page = FindPage( ea );
+	return page != nullptr ? page->instructionLengths[ea % PageSize] : 0;
+}
+
+bool WildcardBitmap::IsWildcard( ea_t ea ) const {
+	const auto page = FindPage( ea );
+	return page != nullptr && TestBit( page->wildcards, ea % PageSize );
+}
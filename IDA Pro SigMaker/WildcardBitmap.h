@@ -0,0 +1,51 @@
+#pragma once
+#include <unordered_map>
+#include <memory>
+#include <cstdint>
+#include <cstddef>
+
+#include "Plugin.h"
+
+// Per byte state of decoded code: the length of the instruction starting there, and which bytes get wildcarded
+// A signature of a marked instruction is then just a slice of the snapshot bytes plus a slice of these bits, without decoding it again
+// Filled lazily one page at a time, so only code near generated signatures gets decoded. Only used from the UI thread, like decode_insn itself
+class WildcardBitmap {
+public:
+	static constexpr size_t PageSize = 0x1000;
+
+	void Clear( );
+	// The wildcarded bytes depend on the wildcardable operand types, the bitmap is cleared when they change
+	void SetOperandTypeBitmask( uint32_t operandTypeBitmask );
+
+	// Whether all instructions starting in the page of ea were added
+	bool IsPageDecoded( ea_t ea ) const;
+	void SetPageDecoded( ea_t ea );
+	void AddInstruction( ea_t ea, size_t length, size_t operandOffset, size_t operandLength );
+
+	// Length of the instruction added at ea, 0 if none starts there
+	size_t GetInstructionLength( ea_t ea ) const;
+	bool IsWildcard( ea_t ea ) const;
+
+	size_t GetMemoryUsage( ) const {
+		return pages.size( ) * sizeof( Page );
+	}
+
+private:
+	static constexpr size_t WordCount = PageSize / 64;
+
+	// Operands can reach into the page after the instruction start, so a page can hold wildcard bits before it is decoded itself
+	struct Page {
+		bool isDecoded;
+		uint8_t instructionLengths[PageSize]; // 0 where no instruction starts
+		uint64_t wildcards[WordCount];
+	};
+
+	static bool TestBit( const uint64_t* bits, size_t index ) {
+		return ( bits[index / 64] >> ( index % 64 ) ) & 1;
+	}
+	const Page* FindPage( ea_t ea ) const;
+	Page& GetPage( ea_t ea );
+
+	uint32_t operandTypeBitmask = 0;
+	std::unordered_map<ea_t, std::unique_ptr<Page>> pages;
+};